@@ -0,0 +1,432 @@
+#include "allocation_profiler.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <unordered_map>
+
+#if defined(__GLIBC__)
+#define ALLOCATION_PROFILER_USE_BACKTRACE 1
+#include <execinfo.h>
+#else
+#define ALLOCATION_PROFILER_USE_BACKTRACE 0
+#endif
+
+namespace {
+
+// Site tags are keyed with the top bit set; stack keys are hashes with it cleared
+constexpr uint64_t TAG_KEY = 1ULL << 63;
+
+// Frames dropped from captured stacks: sample(), recordAllocation(), MemoryManager::sampleAllocation()
+// and the allocation call itself, so every stack starts at the caller
+constexpr int SKIPPED_FRAMES = 4;
+
+uint64_t mixKey(uint64_t key) {
+    key ^= key >> 33;
+    key *= 0xff51afd7ed558ccdULL;
+    key ^= key >> 33;
+    return key;
+}
+
+uint64_t hashFrames(void* const* frames, uint32_t frameCount) {
+    uint64_t hash = 14695981039346656037ULL;
+    for (uint32_t i = 0; i < frameCount; ++i) {
+        hash ^= static_cast<uint64_t>(reinterpret_cast<uintptr_t>(frames[i]));
+        hash *= 1099511628211ULL;
+    }
+    hash &= ~TAG_KEY;
+    return hash == 0 ? 1 : hash;
+}
+
+// Minimal protobuf writer for the pprof profile.proto message
+class ProtoWriter {
+public:
+    void varint(uint64_t value) {
+        while (value >= 0x80) {
+            buffer.push_back(static_cast<char>((value & 0x7f) | 0x80));
+            value >>= 7;
+        }
+        buffer.push_back(static_cast<char>(value));
+    }
+    
+    void tag(uint32_t field, uint32_t wireType) {
+        varint((static_cast<uint64_t>(field) << 3) | wireType);
+    }
+    
+    void integer(uint32_t field, uint64_t value) {
+        if (value != 0) {
+            tag(field, 0);
+            varint(value);
+        }
+    }
+    
+    void bytes(uint32_t field, const std::string& value) {
+        tag(field, 2);
+        varint(value.size());
+        buffer += value;
+    }
+    
+    void packed(uint32_t field, const std::vector<uint64_t>& values) {
+        ProtoWriter inner;
+        for (uint64_t value : values) {
+            inner.varint(value);
+        }
+        bytes(field, inner.buffer);
+    }
+    
+    std::string buffer;
+};
+
+// Interns strings for the profile's string table; index 0 is always ""
+class StringTable {
+public:
+    StringTable() {
+        intern("");
+    }
+    
+    uint64_t intern(const std::string& value) {
+        auto it = indices.find(value);
+        if (it != indices.end()) {
+            return it->second;
+        }
+        indices.emplace(value, strings.size());
+        strings.push_back(value);
+        return strings.size() - 1;
+    }
+    
+    std::vector<std::string> strings;
+    
+private:
+    std::unordered_map<std::string, uint64_t> indices;
+};
+
+std::string symbolize(void* frame) {
+#if ALLOCATION_PROFILER_USE_BACKTRACE
+    char** symbols = backtrace_symbols(&frame, 1);
+    if (symbols) {
+        // "binary(function+0x1c) [0x4005d4]": keep the function when there is one
+        std::string symbol = symbols[0];
+        std::free(symbols);
+        size_t open = symbol.find('(');
+        size_t plus = symbol.find('+', open);
+        if (open != std::string::npos && plus != std::string::npos && plus > open + 1) {
+            return symbol.substr(open + 1, plus - open - 1);
+        }
+    }
+#endif
+    char address[32];
+    std::snprintf(address, sizeof(address), "%p", frame);
+    return address;
+}
+
+} // namespace
+
+// AllocationProfiler implementation
+AllocationProfiler::AllocationProfiler()
+    : slots(new SiteSlot[TABLE_SIZE]), samplingInterval(DEFAULT_SAMPLING_INTERVAL),
+      captureStacks(false), droppedSamples(0), previousStatsTime(std::chrono::steady_clock::now()) {
+    for (size_t i = 0; i < TABLE_SIZE; ++i) {
+        SiteSlot& slot = slots[i];
+        slot.key.store(0, std::memory_order_relaxed);
+        slot.ready.store(false, std::memory_order_relaxed);
+        slot.frameCount = 0;
+        slot.allocatedObjects.store(0, std::memory_order_relaxed);
+        slot.allocatedBytes.store(0, std::memory_order_relaxed);
+        slot.liveObjects.store(0, std::memory_order_relaxed);
+        slot.liveBytes.store(0, std::memory_order_relaxed);
+    }
+    
+    siteNames.push_back("untagged");
+    previousAllocatedBytes.assign(TABLE_SIZE, 0);
+}
+
+size_t AllocationProfiler::getSamplingInterval() const {
+    return samplingInterval.load(std::memory_order_relaxed);
+}
+
+void AllocationProfiler::setSamplingInterval(size_t bytes) {
+    samplingInterval.store(bytes, std::memory_order_relaxed);
+}
+
+bool AllocationProfiler::isCapturingStacks() const {
+    return captureStacks.load(std::memory_order_relaxed);
+}
+
+void AllocationProfiler::setCaptureStacks(bool captureStacks) {
+    this->captureStacks.store(captureStacks && ALLOCATION_PROFILER_USE_BACKTRACE, std::memory_order_relaxed);
+}
+
+uint32_t AllocationProfiler::registerSite(const std::string& name) {
+    std::lock_guard<std::mutex> lock(sitesMutex);
+    auto existing = std::find(siteNames.begin(), siteNames.end(), name);
+    if (existing != siteNames.end()) {
+        return static_cast<uint32_t>(existing - siteNames.begin());
+    }
+    siteNames.push_back(name);
+    return static_cast<uint32_t>(siteNames.size() - 1);
+}
+
+int64_t AllocationProfiler::nextSampleDistance(SweepRandom& random) const {
+    size_t interval = getSamplingInterval();
+    if (interval == 0) {
+        // Off: check back after a large stretch so a later setSamplingInterval() still takes effect
+        return static_cast<int64_t>(1) << 40;
+    }
+    
+    // Exponential gaps make sampling a Poisson process over the bytes allocated, so no
+    // allocation pattern can line up with the sampler and dodge it
+    double uniform = static_cast<double>((random.next() >> 11) + 1) / 9007199254740993.0;
+    double distance = -std::log(uniform) * static_cast<double>(interval);
+    return static_cast<int64_t>(std::min(distance, 1e15)) + 1;
+}
+
+void AllocationProfiler::recordAllocation(MemoryBlock& block, uint32_t site) {
+    block.setSample(sample(block.getSize(), site));
+}
+
+void AllocationProfiler::recordAllocation(ObjectAllocation& allocation, uint32_t site) {
+    allocation.sample = sample(allocation.size, site);
+}
+
+void AllocationProfiler::recordFree(MemoryBlock& block) {
+    release(block.takeSample(), block.getSize());
+}
+
+void AllocationProfiler::recordFree(const ObjectAllocation& allocation) {
+    release(allocation.sample, allocation.size);
+}
+
+void AllocationProfiler::clearLive() {
+    for (size_t i = 0; i < TABLE_SIZE; ++i) {
+        slots[i].liveObjects.store(0, std::memory_order_relaxed);
+        slots[i].liveBytes.store(0, std::memory_order_relaxed);
+    }
+}
+
+uint64_t AllocationProfiler::getDroppedSamples() const {
+    return droppedSamples.load(std::memory_order_relaxed);
+}
+
+uint32_t AllocationProfiler::sample(size_t size, uint32_t site) {
+    size_t interval = getSamplingInterval();
+    if (interval == 0 || size == 0) {
+        return NOT_SAMPLED;
+    }
+    
+    // An allocation of size bytes is sampled with probability 1 - e^(-size/interval),
+    // so each sample stands for the reciprocal of that many allocations like it.
+    // Only tiny objects under an interval of many megabytes reach the cap.
+    double probability = -std::expm1(-static_cast<double>(size) / static_cast<double>(interval));
+    double weight = std::round(1.0 / probability);
+    uint32_t sampleCount = static_cast<uint32_t>(std::min(std::max(weight, 1.0), static_cast<double>(MAX_SAMPLE_COUNT)));
+    
+    int32_t slot;
+    if (site == UNTAGGED_SITE && isCapturingStacks()) {
+#if ALLOCATION_PROFILER_USE_BACKTRACE
+        void* frames[MAX_STACK_DEPTH + SKIPPED_FRAMES];
+        int depth = backtrace(frames, static_cast<int>(MAX_STACK_DEPTH + SKIPPED_FRAMES));
+        int skipped = std::min(depth, SKIPPED_FRAMES);
+        uint32_t frameCount = static_cast<uint32_t>(depth - skipped);
+        slot = findSlot(hashFrames(frames + skipped, frameCount), frames + skipped, frameCount);
+#else
+        slot = findSlot(TAG_KEY | site, nullptr, 0);
+#endif
+    } else {
+        slot = findSlot(TAG_KEY | site, nullptr, 0);
+    }
+    
+    if (slot < 0) {
+        droppedSamples.fetch_add(1, std::memory_order_relaxed);
+        return NOT_SAMPLED;
+    }
+    
+    uint64_t bytes = static_cast<uint64_t>(size) * sampleCount;
+    SiteSlot& entry = slots[slot];
+    entry.allocatedObjects.fetch_add(sampleCount, std::memory_order_relaxed);
+    entry.allocatedBytes.fetch_add(bytes, std::memory_order_relaxed);
+    entry.liveObjects.fetch_add(sampleCount, std::memory_order_relaxed);
+    entry.liveBytes.fetch_add(bytes, std::memory_order_relaxed);
+    return (static_cast<uint32_t>(slot) << SAMPLE_COUNT_BITS) | sampleCount;
+}
+
+void AllocationProfiler::release(uint32_t record, size_t size) {
+    if (record == NOT_SAMPLED) {
+        return;
+    }
+    uint32_t slot = record >> SAMPLE_COUNT_BITS;
+    uint32_t sampleCount = record & MAX_SAMPLE_COUNT;
+    
+    // clearLive() may have zeroed the counters since this sample was taken
+    SiteSlot& entry = slots[slot];
+    uint64_t bytes = static_cast<uint64_t>(size) * sampleCount;
+    uint64_t objects = entry.liveObjects.load(std::memory_order_relaxed);
+    while (!entry.liveObjects.compare_exchange_weak(objects, objects - std::min<uint64_t>(objects, sampleCount),
+                                                    std::memory_order_relaxed)) {}
+    uint64_t live = entry.liveBytes.load(std::memory_order_relaxed);
+    while (!entry.liveBytes.compare_exchange_weak(live, live - std::min(live, bytes), std::memory_order_relaxed)) {}
+}
+
+int32_t AllocationProfiler::findSlot(uint64_t key, void* const* frames, uint32_t frameCount) {
+    size_t index = mixKey(key) & (TABLE_SIZE - 1);
+    for (size_t probe = 0; probe < TABLE_SIZE; ++probe) {
+        SiteSlot& slot = slots[index];
+        uint64_t current = slot.key.load(std::memory_order_acquire);
+        
+        if (current == 0) {
+            uint64_t expected = 0;
+            if (slot.key.compare_exchange_strong(expected, key, std::memory_order_acq_rel)) {
+                // Only the thread that claimed the slot writes its frames
+                std::copy(frames, frames + frameCount, slot.frames);
+                slot.frameCount = frameCount;
+                slot.ready.store(true, std::memory_order_release);
+                return static_cast<int32_t>(index);
+            }
+            current = expected;
+        }
+        
+        if (current == key) {
+            return static_cast<int32_t>(index);
+        }
+        index = (index + 1) & (TABLE_SIZE - 1);
+    }
+    return -1;
+}
+
+std::string AllocationProfiler::getSiteName(const SiteSlot& slot) const {
+    uint64_t key = slot.key.load(std::memory_order_relaxed);
+    if (key & TAG_KEY) {
+        uint64_t site = key & ~TAG_KEY;
+        std::lock_guard<std::mutex> lock(sitesMutex);
+        return site < siteNames.size() ? siteNames[site] : "site " + std::to_string(site);
+    }
+    
+    char name[32];
+    std::snprintf(name, sizeof(name), "stack %016llx", static_cast<unsigned long long>(key));
+    return name;
+}
+
+std::vector<AllocationSiteStats> AllocationProfiler::getSiteStats() {
+    std::lock_guard<std::mutex> lock(statsMutex);
+    
+    auto now = std::chrono::steady_clock::now();
+    double elapsed = std::chrono::duration<double>(now - previousStatsTime).count();
+    previousStatsTime = now;
+    
+    std::vector<AllocationSiteStats> stats;
+    for (size_t i = 0; i < TABLE_SIZE; ++i) {
+        const SiteSlot& slot = slots[i];
+        if (!slot.ready.load(std::memory_order_acquire)) {
+            continue;
+        }
+        
+        AllocationSiteStats site;
+        site.site = getSiteName(slot);
+        site.allocatedObjects = slot.allocatedObjects.load(std::memory_order_relaxed);
+        site.allocatedBytes = slot.allocatedBytes.load(std::memory_order_relaxed);
+        site.liveObjects = slot.liveObjects.load(std::memory_order_relaxed);
+        site.liveBytes = slot.liveBytes.load(std::memory_order_relaxed);
+        
+        uint64_t allocatedSince = site.allocatedBytes - previousAllocatedBytes[i];
+        site.allocatedBytesPerSecond = elapsed > 0.0 ? allocatedSince / elapsed : 0.0;
+        previousAllocatedBytes[i] = site.allocatedBytes;
+        
+        stats.push_back(site);
+    }
+    
+    std::sort(stats.begin(), stats.end(), [](const AllocationSiteStats& a, const AllocationSiteStats& b) {
+        return a.liveBytes > b.liveBytes;
+    });
+    return stats;
+}
+
+std::string AllocationProfiler::exportPprof() const {
+    // Field numbers from github.com/google/pprof/proto/profile.proto
+    enum ProfileField { SAMPLE_TYPE = 1, SAMPLE = 2, LOCATION = 4, FUNCTION = 5, STRING_TABLE = 6,
+                        TIME_NANOS = 9, PERIOD_TYPE = 11, PERIOD = 12 };
+    
+    StringTable strings;
+    ProtoWriter profile;
+    
+    auto valueType = [&strings](const std::string& type, const std::string& unit) {
+        ProtoWriter message;
+        message.integer(1, strings.intern(type));
+        message.integer(2, strings.intern(unit));
+        return message.buffer;
+    };
+    
+    profile.bytes(SAMPLE_TYPE, valueType("alloc_objects", "count"));
+    profile.bytes(SAMPLE_TYPE, valueType("alloc_space", "bytes"));
+    profile.bytes(SAMPLE_TYPE, valueType("inuse_objects", "count"));
+    profile.bytes(SAMPLE_TYPE, valueType("inuse_space", "bytes"));
+    
+    // One function and one location per distinct frame address or site tag
+    std::unordered_map<std::string, uint64_t> locationIds;
+    ProtoWriter locations;
+    ProtoWriter functions;
+    
+    auto locationFor = [&](const std::string& name, uint64_t address) {
+        std::string key = address ? std::to_string(address) : "tag:" + name;
+        auto it = locationIds.find(key);
+        if (it != locationIds.end()) {
+            return it->second;
+        }
+        uint64_t id = locationIds.size() + 1;
+        locationIds.emplace(key, id);
+        
+        ProtoWriter function;
+        function.integer(1, id);
+        function.integer(2, strings.intern(name));
+        function.integer(3, strings.intern(name));
+        functions.bytes(FUNCTION, function.buffer);
+        
+        ProtoWriter line;
+        line.integer(1, id);
+        ProtoWriter location;
+        location.integer(1, id);
+        location.integer(3, address);
+        location.bytes(4, line.buffer);
+        locations.bytes(LOCATION, location.buffer);
+        return id;
+    };
+    
+    for (size_t i = 0; i < TABLE_SIZE; ++i) {
+        const SiteSlot& slot = slots[i];
+        if (!slot.ready.load(std::memory_order_acquire)) {
+            continue;
+        }
+        
+        std::vector<uint64_t> locationIdsForSample;
+        if (slot.frameCount == 0) {
+            locationIdsForSample.push_back(locationFor(getSiteName(slot), 0));
+        } else {
+            for (uint32_t f = 0; f < slot.frameCount; ++f) {
+                uint64_t address = static_cast<uint64_t>(reinterpret_cast<uintptr_t>(slot.frames[f]));
+                locationIdsForSample.push_back(locationFor(symbolize(slot.frames[f]), address));
+            }
+        }
+        
+        ProtoWriter sample;
+        sample.packed(1, locationIdsForSample);
+        sample.packed(2, {
+            slot.allocatedObjects.load(std::memory_order_relaxed),
+            slot.allocatedBytes.load(std::memory_order_relaxed),
+            slot.liveObjects.load(std::memory_order_relaxed),
+            slot.liveBytes.load(std::memory_order_relaxed)
+        });
+        profile.bytes(SAMPLE, sample.buffer);
+    }
+    
+    profile.buffer += locations.buffer;
+    profile.buffer += functions.buffer;
+    
+    std::string periodType = valueType("space", "bytes");
+    for (const std::string& value : strings.strings) {
+        profile.bytes(STRING_TABLE, value);
+    }
+    
+    auto now = std::chrono::system_clock::now().time_since_epoch();
+    profile.integer(TIME_NANOS, std::chrono::duration_cast<std::chrono::nanoseconds>(now).count());
+    profile.bytes(PERIOD_TYPE, periodType);
+    profile.integer(PERIOD, getSamplingInterval());
+    return profile.buffer;
+}
@@ -0,0 +1,97 @@
+#ifndef ALLOCATION_PROFILER_H
+#define ALLOCATION_PROFILER_H
+
+#include "memory_manager.h"
+
+// Allocation site stats: estimated totals for one site, scaled up from the samples
+struct AllocationSiteStats {
+    std::string site;
+    uint64_t allocatedObjects;
+    uint64_t allocatedBytes;
+    uint64_t liveObjects;
+    uint64_t liveBytes;
+    double allocatedBytesPerSecond; // Since the previous getSiteStats() call
+};
+
+// Allocation Profiler class
+// Samples allocations Poisson-style, on average once every samplingInterval
+// bytes, so the cost stays proportional to bytes allocated rather than to
+// allocation count. Each sample is weighted by the inverse of its sampling
+// probability and charged to a site: the tag the caller passed or, if none,
+// the captured call stack. Sites live in a fixed lock-free hash table.
+class AllocationProfiler {
+public:
+    static constexpr size_t DEFAULT_SAMPLING_INTERVAL = 512 * 1024;
+    static constexpr size_t TABLE_SIZE = 1024; // Power of two; samples for further sites are dropped
+    static constexpr size_t MAX_STACK_DEPTH = 32;
+    static constexpr uint32_t UNTAGGED_SITE = 0;
+    
+    // A sample record packs the site's slot above the number of allocations the sample stands for
+    static constexpr uint32_t NOT_SAMPLED = 0;
+    static constexpr uint32_t SAMPLE_COUNT_BITS = 22;
+    static constexpr uint32_t MAX_SAMPLE_COUNT = (1u << SAMPLE_COUNT_BITS) - 1;
+    
+    AllocationProfiler();
+    
+    size_t getSamplingInterval() const;
+    // 0 turns sampling off; threads pick up the new interval after their next sample
+    void setSamplingInterval(size_t bytes);
+    bool isCapturingStacks() const;
+    // Untagged allocations are charged to their call stack instead of a single "untagged" site
+    void setCaptureStacks(bool captureStacks);
+    
+    // Returns the tag to pass to the allocation calls
+    uint32_t registerSite(const std::string& name);
+    
+    // Distance in bytes to a thread's next sample
+    int64_t nextSampleDistance(SweepRandom& random) const;
+    
+    // Sampled allocations remember their site so frees can be charged back to it
+    void recordAllocation(MemoryBlock& block, uint32_t site);
+    void recordAllocation(ObjectAllocation& allocation, uint32_t site);
+    void recordFree(MemoryBlock& block);
+    void recordFree(const ObjectAllocation& allocation);
+    // The heap was replaced wholesale; nothing sampled before is live any more
+    void clearLive();
+    
+    uint64_t getDroppedSamples() const;
+    // Sites with any sampled allocation, largest live heap first
+    std::vector<AllocationSiteStats> getSiteStats();
+    // Heap profile in pprof's protobuf format: alloc_objects, alloc_space, inuse_objects, inuse_space
+    std::string exportPprof() const;
+    
+private:
+    struct SiteSlot {
+        std::atomic<uint64_t> key; // 0 while the slot is empty
+        std::atomic<bool> ready; // frames are written once, before ready is set
+        uint32_t frameCount;
+        void* frames[MAX_STACK_DEPTH];
+        std::atomic<uint64_t> allocatedObjects;
+        std::atomic<uint64_t> allocatedBytes;
+        std::atomic<uint64_t> liveObjects;
+        std::atomic<uint64_t> liveBytes;
+    };
+    
+    static_assert(TABLE_SIZE <= (1ull << (32 - SAMPLE_COUNT_BITS)), "slot does not fit in a sample record");
+    
+    // Charges a sampled allocation to its site; returns its record, or NOT_SAMPLED if the table is full
+    ALLOCATION_PROFILER_NOINLINE uint32_t sample(size_t size, uint32_t site);
+    void release(uint32_t record, size_t size);
+    // -1 once the table is full
+    int32_t findSlot(uint64_t key, void* const* frames, uint32_t frameCount);
+    std::string getSiteName(const SiteSlot& slot) const;
+    
+    std::unique_ptr<SiteSlot[]> slots;
+    std::atomic<size_t> samplingInterval;
+    std::atomic<bool> captureStacks;
+    std::atomic<uint64_t> droppedSamples;
+    
+    mutable std::mutex sitesMutex;
+    std::vector<std::string> siteNames; // Indexed by site tag
+    
+    std::mutex statsMutex;
+    std::vector<uint64_t> previousAllocatedBytes;
+    std::chrono::steady_clock::time_point previousStatsTime;
+};
+
+#endif // ALLOCATION_PROFILER_H
@@ -0,0 +1,94 @@
+#include "finalization_queue.h"
+#include <exception>
+#include <iostream>
+#include <iterator>
+
+// FinalizationQueue implementation
+FinalizationQueue::FinalizationQueue(Releaser releaser)
+    : releaser(std::move(releaser)), runningCount(0), stopping(false), finalizedCount(0) {
+    worker = std::thread(&FinalizationQueue::workerLoop, this);
+}
+
+FinalizationQueue::~FinalizationQueue() {
+    shutdown();
+}
+
+void FinalizationQueue::submit(std::vector<PendingFinalization>& batch) {
+    if (batch.empty()) {
+        return;
+    }
+    
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (pending.empty()) {
+            pending.swap(batch);
+        } else {
+            pending.insert(pending.end(), std::make_move_iterator(batch.begin()), std::make_move_iterator(batch.end()));
+            batch.clear();
+        }
+    }
+    workCondition.notify_one();
+}
+
+void FinalizationQueue::drain() {
+    std::unique_lock<std::mutex> lock(mutex);
+    drainedCondition.wait(lock, [this]() { return pending.empty() && runningCount == 0; });
+}
+
+size_t FinalizationQueue::getPendingCount() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return pending.size() + runningCount;
+}
+
+uint64_t FinalizationQueue::getFinalizedCount() const {
+    return finalizedCount.load(std::memory_order_relaxed);
+}
+
+void FinalizationQueue::shutdown() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    workCondition.notify_all();
+    
+    if (worker.joinable()) {
+        worker.join();
+    }
+}
+
+void FinalizationQueue::workerLoop() {
+    std::vector<PendingFinalization> batch;
+    
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+        workCondition.wait(lock, [this]() { return stopping || !pending.empty(); });
+        if (pending.empty()) {
+            return; // Stopping, and everything queued has run
+        }
+        
+        // The emptied batch goes back as the queue, so neither side allocates in steady state
+        batch.swap(pending);
+        runningCount = batch.size();
+        lock.unlock();
+        
+        for (PendingFinalization& entry : batch) {
+            // A throwing finalizer must not take the worker down or keep its block from being freed
+            try {
+                entry.finalizer(*entry.block);
+            } catch (const std::exception& e) {
+                std::cerr << "Finalizer for block " << entry.block->getId() << " threw: " << e.what() << std::endl;
+            } catch (...) {
+                std::cerr << "Finalizer for block " << entry.block->getId() << " threw" << std::endl;
+            }
+            releaser(entry.block);
+            finalizedCount.fetch_add(1, std::memory_order_relaxed);
+        }
+        batch.clear();
+        
+        lock.lock();
+        runningCount = 0;
+        if (pending.empty()) {
+            drainedCondition.notify_all();
+        }
+    }
+}
@@ -0,0 +1,54 @@
+#ifndef FINALIZATION_QUEUE_H
+#define FINALIZATION_QUEUE_H
+
+#include "memory_manager.h"
+
+// Pending finalization: a dead block kept pinned until its finalizer has run
+struct PendingFinalization {
+    std::shared_ptr<MemoryBlock> block;
+    BlockFinalizer finalizer;
+};
+
+// Finalization Queue class
+// Runs finalizers on one worker thread, away from the collection that found
+// their blocks dead. Collections hand over everything they found in a single
+// batch, and the worker swaps out the whole queue at once, so each batch costs
+// one lock and one wakeup on either side however many blocks it holds.
+class FinalizationQueue {
+public:
+    // Frees a block once its finalizer has run; called on the worker thread
+    using Releaser = std::function<void(const std::shared_ptr<MemoryBlock>&)>;
+    
+    explicit FinalizationQueue(Releaser releaser);
+    ~FinalizationQueue();
+    
+    FinalizationQueue(const FinalizationQueue&) = delete;
+    FinalizationQueue& operator=(const FinalizationQueue&) = delete;
+    
+    // Takes every entry out of batch, leaving it empty for reuse
+    void submit(std::vector<PendingFinalization>& batch);
+    // Waits until everything submitted so far has been finalized
+    void drain();
+    // Queued or running
+    size_t getPendingCount() const;
+    uint64_t getFinalizedCount() const;
+    
+    // Runs what is still queued, then joins the worker
+    void shutdown();
+    
+private:
+    void workerLoop();
+    
+    Releaser releaser;
+    
+    mutable std::mutex mutex;
+    std::condition_variable workCondition;
+    std::condition_variable drainedCondition;
+    std::vector<PendingFinalization> pending;
+    size_t runningCount;
+    bool stopping;
+    std::atomic<uint64_t> finalizedCount;
+    std::thread worker;
+};
+
+#endif // FINALIZATION_QUEUE_H
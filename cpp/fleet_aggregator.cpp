@@ -0,0 +1,514 @@
+#include "fleet_aggregator.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <json/json.h> // Requires JsonCpp library
+
+#if defined(_WIN32)
+#define FLEET_USE_UNIX_SOCKETS 0
+#else
+#define FLEET_USE_UNIX_SOCKETS 1
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+const size_t READ_CHUNK_SIZE = 16 * 1024;
+
+// Counters only grow unless the instance restarted or restored a snapshot; then all of the new value is new
+uint64_t counterDelta(uint64_t current, uint64_t previous) {
+    return current >= previous ? current - previous : current;
+}
+
+Json::Value histogramJson(const FleetHistogram& histogram) {
+    Json::Value value;
+    value["count"] = static_cast<Json::UInt64>(histogram.count);
+    value["sumSeconds"] = histogram.sumMicros / 1000000.0;
+    Json::Value buckets(Json::arrayValue);
+    for (uint64_t bucket : histogram.buckets) {
+        buckets.append(static_cast<Json::UInt64>(bucket));
+    }
+    value["buckets"] = buckets;
+    return value;
+}
+
+// JavaScript numbers cannot hold every 64-bit id, so ids go out as hex strings
+std::string instanceIdString(uint64_t instanceId) {
+    char text[17];
+    std::snprintf(text, sizeof(text), "%016llx", static_cast<unsigned long long>(instanceId));
+    return text;
+}
+
+} // namespace
+
+// FleetAggregator implementation
+FleetAggregator::FleetAggregator(const std::string& socketPath, FeedListener listener,
+                                 std::chrono::milliseconds feedInterval)
+    : socketPath(socketPath), listener(std::move(listener)), feedInterval(feedInterval),
+      listenFd(-1), wakeFds{-1, -1}, running(false), totals(), feedDirty(false), feedSequence(0) {}
+
+FleetAggregator::~FleetAggregator() {
+    stop();
+}
+
+bool FleetAggregator::start() {
+#if FLEET_USE_UNIX_SOCKETS
+    if (running) {
+        return false;
+    }
+    
+    sockaddr_un address;
+    std::memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    if (socketPath.empty() || socketPath.size() >= sizeof(address.sun_path)) {
+        return false;
+    }
+    std::memcpy(address.sun_path, socketPath.c_str(), socketPath.size());
+    
+    listenFd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listenFd < 0) {
+        return false;
+    }
+    
+    // A socket file nobody answers on was left by a crashed aggregator; a live one is left alone
+    if (connect(listenFd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) == 0) {
+        close(listenFd);
+        listenFd = -1;
+        return false;
+    }
+    close(listenFd);
+    unlink(socketPath.c_str());
+    
+    listenFd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listenFd < 0 || bind(listenFd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 ||
+        listen(listenFd, SOMAXCONN) != 0 || pipe(wakeFds) != 0) {
+        if (listenFd >= 0) {
+            close(listenFd);
+            listenFd = -1;
+        }
+        wakeFds[0] = wakeFds[1] = -1;
+        return false;
+    }
+    fcntl(listenFd, F_SETFL, O_NONBLOCK);
+    fcntl(wakeFds[0], F_SETFL, O_NONBLOCK);
+    fcntl(wakeFds[1], F_SETFL, O_NONBLOCK);
+    
+    running = true;
+    thread = std::thread(&FleetAggregator::aggregatorThread, this);
+    return true;
+#else
+    return false;
+#endif
+}
+
+void FleetAggregator::stop() {
+#if FLEET_USE_UNIX_SOCKETS
+    if (!running.exchange(false)) {
+        return;
+    }
+    
+    char wake = 1;
+    (void)!write(wakeFds[1], &wake, 1);
+    if (thread.joinable()) {
+        thread.join();
+    }
+    
+    for (Connection& connection : connections) {
+        closeConnection(connection);
+    }
+    connections.clear();
+    close(listenFd);
+    close(wakeFds[0]);
+    close(wakeFds[1]);
+    listenFd = -1;
+    wakeFds[0] = wakeFds[1] = -1;
+    unlink(socketPath.c_str());
+#endif
+}
+
+FleetTotals FleetAggregator::getTotals() const {
+    std::lock_guard<std::mutex> lock(stateMutex);
+    return currentTotals();
+}
+
+std::vector<FleetInstance> FleetAggregator::getInstances() const {
+    std::lock_guard<std::mutex> lock(stateMutex);
+    
+    std::vector<FleetInstance> result;
+    result.reserve(instances.size());
+    for (const auto& entry : instances) {
+        result.push_back(entry.second);
+    }
+    return result;
+}
+
+std::vector<FleetActivity> FleetAggregator::getRecentActivities(size_t limit) const {
+    std::lock_guard<std::mutex> lock(stateMutex);
+    size_t count = std::min(limit, recentActivities.size());
+    return std::vector<FleetActivity>(recentActivities.begin(), recentActivities.begin() + count);
+}
+
+void FleetAggregator::aggregatorThread() {
+#if FLEET_USE_UNIX_SOCKETS
+    std::vector<pollfd> fds;
+    auto nextFeed = std::chrono::steady_clock::now() + feedInterval;
+    
+    while (running) {
+        fds.clear();
+        fds.push_back({wakeFds[0], POLLIN, 0});
+        fds.push_back({listenFd, POLLIN, 0});
+        for (const Connection& connection : connections) {
+            fds.push_back({connection.fd, POLLIN, 0});
+        }
+        
+        auto wait = std::chrono::duration_cast<std::chrono::milliseconds>(nextFeed - std::chrono::steady_clock::now());
+        int ready = poll(fds.data(), fds.size(), static_cast<int>(std::max<int64_t>(0, wait.count())));
+        
+        if (ready > 0) {
+            if (fds[0].revents & POLLIN) {
+                char drain[64];
+                while (read(wakeFds[0], drain, sizeof(drain)) > 0) {}
+            }
+            
+            // Connections first: accepting appends to the list the poll results are indexed by
+            for (size_t i = 0; i < connections.size(); ++i) {
+                if (fds[i + 2].revents && !readConnection(connections[i])) {
+                    closeConnection(connections[i]);
+                }
+            }
+            connections.erase(std::remove_if(connections.begin(), connections.end(),
+                                             [](const Connection& connection) { return connection.fd < 0; }),
+                              connections.end());
+            
+            if (fds[1].revents & POLLIN) {
+                acceptConnections();
+            }
+        }
+        
+        auto now = std::chrono::steady_clock::now();
+        if (now >= nextFeed) {
+            expireInstances(now);
+            publishFeed();
+            nextFeed = now + feedInterval;
+        }
+    }
+#endif
+}
+
+void FleetAggregator::acceptConnections() {
+#if FLEET_USE_UNIX_SOCKETS
+    while (true) {
+        int fd = accept(listenFd, nullptr, nullptr);
+        if (fd < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return;
+        }
+        if (connections.size() >= MAX_CONNECTIONS) {
+            close(fd);
+            continue;
+        }
+        fcntl(fd, F_SETFL, O_NONBLOCK);
+        connections.push_back(Connection{fd, std::string(), false, 0});
+    }
+#endif
+}
+
+bool FleetAggregator::readConnection(Connection& connection) {
+#if FLEET_USE_UNIX_SOCKETS
+    char chunk[READ_CHUNK_SIZE];
+    while (true) {
+        ssize_t received = read(connection.fd, chunk, sizeof(chunk));
+        if (received < 0 && errno == EINTR) {
+            continue;
+        }
+        if (received < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            return true;
+        }
+        if (received <= 0) {
+            return false;
+        }
+        connection.input.append(chunk, static_cast<size_t>(received));
+        
+        // Parse after every chunk so a peer that floods the socket never buffers more than one frame
+        size_t consumed = 0;
+        while (connection.input.size() - consumed >= FleetProtocol::HEADER_SIZE) {
+            uint8_t type;
+            uint32_t payloadSize;
+            if (!FleetProtocol::decodeHeader(connection.input.data() + consumed, type, payloadSize)) {
+                return false;
+            }
+            if (connection.input.size() - consumed - FleetProtocol::HEADER_SIZE < payloadSize) {
+                break;
+            }
+            if (!handleFrame(connection, type, connection.input.data() + consumed + FleetProtocol::HEADER_SIZE,
+                             payloadSize)) {
+                return false;
+            }
+            consumed += FleetProtocol::HEADER_SIZE + payloadSize;
+        }
+        connection.input.erase(0, consumed);
+    }
+#else
+    (void)connection;
+    return false;
+#endif
+}
+
+bool FleetAggregator::handleFrame(Connection& connection, uint8_t type, const char* payload, size_t size) {
+    // Every connection must introduce itself before anything else, and only once
+    if (!connection.identified) {
+        FleetHello hello;
+        if (type != static_cast<uint8_t>(FleetMessageType::HELLO) ||
+            !FleetProtocol::decodeHello(payload, size, hello)) {
+            return false;
+        }
+        
+        std::lock_guard<std::mutex> lock(stateMutex);
+        // An id can only be live on one connection; interleaved snapshots from two would read as resets.
+        // The duplicate is closed unidentified, so the live instance is left alone.
+        auto existing = instances.find(hello.instanceId);
+        if (existing != instances.end() && existing->second.connected) {
+            return false;
+        }
+        connection.identified = true;
+        connection.instanceId = hello.instanceId;
+        
+        // A known id is the same process reconnecting; its last snapshot stays the baseline for deltas,
+        // also once the instance has expired from the feed
+        auto inserted = instances.emplace(hello.instanceId, FleetInstance());
+        FleetInstance& instance = inserted.first->second;
+        if (inserted.second) {
+            auto baseline = baselines.find(hello.instanceId);
+            if (baseline != baselines.end()) {
+                instance = baseline->second;
+                baselines.erase(baseline);
+            } else {
+                instance.instanceId = hello.instanceId;
+                instance.hasStats = false;
+                instance.stats = FleetStats();
+            }
+        }
+        instance.pid = hello.pid;
+        instance.name = hello.name;
+        instance.connected = true;
+        instance.lastSeen = std::chrono::steady_clock::now();
+        feedDirty = true;
+        return true;
+    }
+    
+    switch (static_cast<FleetMessageType>(type)) {
+        case FleetMessageType::HELLO:
+            return false;
+        
+        case FleetMessageType::STATS: {
+            FleetStats stats;
+            if (!FleetProtocol::decodeStats(payload, size, stats)) {
+                return false;
+            }
+            std::lock_guard<std::mutex> lock(stateMutex);
+            mergeStats(instances[connection.instanceId], stats);
+            return true;
+        }
+        
+        case FleetMessageType::ACTIVITIES: {
+            decodedActivities.clear();
+            if (!FleetProtocol::decodeActivities(payload, size, decodedActivities)) {
+                return false;
+            }
+            std::lock_guard<std::mutex> lock(stateMutex);
+            for (FleetActivity& activity : decodedActivities) {
+                activity.instanceId = connection.instanceId;
+                recentActivities.push_front(activity);
+                if (feedActivities.size() < MAX_RECENT_ACTIVITIES) {
+                    feedActivities.push_back(activity);
+                }
+            }
+            while (recentActivities.size() > MAX_RECENT_ACTIVITIES) {
+                recentActivities.pop_back();
+            }
+            feedDirty = feedDirty || !decodedActivities.empty();
+            return true;
+        }
+    }
+    
+    // Newer publishers may send frame types this aggregator does not know yet
+    return true;
+}
+
+void FleetAggregator::closeConnection(Connection& connection) {
+#if FLEET_USE_UNIX_SOCKETS
+    if (connection.fd >= 0) {
+        close(connection.fd);
+        connection.fd = -1;
+    }
+#endif
+    if (!connection.identified) {
+        return;
+    }
+    
+    std::lock_guard<std::mutex> lock(stateMutex);
+    auto found = instances.find(connection.instanceId);
+    if (found != instances.end()) {
+        found->second.connected = false;
+        found->second.lastSeen = std::chrono::steady_clock::now();
+        feedDirty = true;
+    }
+}
+
+void FleetAggregator::mergeStats(FleetInstance& instance, const FleetStats& stats) {
+    // Only what changed since this instance's previous snapshot is added to the fleet
+    const FleetStats* previous = instance.hasStats ? &instance.stats : nullptr;
+    totals.gcRuns += counterDelta(stats.gcRuns, previous ? previous->gcRuns : 0);
+    totals.memoryReclaimed += counterDelta(stats.memoryReclaimed, previous ? previous->memoryReclaimed : 0);
+    totals.releasedMemory += counterDelta(stats.releasedMemory, previous ? previous->releasedMemory : 0);
+    for (size_t i = 0; i < totals.pauses.size(); ++i) {
+        totals.pauses[i].add(previous ? stats.pauses[i].since(previous->pauses[i]) : stats.pauses[i]);
+    }
+    
+    instance.stats = stats;
+    instance.hasStats = true;
+    instance.lastSeen = std::chrono::steady_clock::now();
+    feedDirty = true;
+}
+
+FleetTotals FleetAggregator::currentTotals() const {
+    // Gauges describe the present, so only instances that are still connected count
+    FleetTotals result = totals;
+    result.instances = instances.size();
+    for (const auto& entry : instances) {
+        const FleetInstance& instance = entry.second;
+        if (!instance.connected) {
+            continue;
+        }
+        result.connectedInstances++;
+        if (instance.hasStats) {
+            result.totalMemory += instance.stats.totalMemory;
+            result.usedMemory += instance.stats.usedMemory;
+            result.freeMemory += instance.stats.freeMemory;
+            result.maxPressureLevel = std::max(result.maxPressureLevel, instance.stats.pressureLevel);
+        }
+    }
+    return result;
+}
+
+void FleetAggregator::expireInstances(std::chrono::steady_clock::time_point now) {
+    std::lock_guard<std::mutex> lock(stateMutex);
+    for (auto it = instances.begin(); it != instances.end();) {
+        if (!it->second.connected && now - it->second.lastSeen > INSTANCE_EXPIRY) {
+            if (it->second.hasStats) {
+                baselines[it->first] = it->second;
+            }
+            it = instances.erase(it);
+            feedDirty = true;
+        } else {
+            ++it;
+        }
+    }
+    
+    // Rare, and only after many instances have come and gone, so a scan for the oldest will do
+    while (baselines.size() > MAX_BASELINES) {
+        auto oldest = std::min_element(baselines.begin(), baselines.end(),
+            [](const std::pair<const uint64_t, FleetInstance>& a, const std::pair<const uint64_t, FleetInstance>& b) {
+                return a.second.lastSeen < b.second.lastSeen;
+            });
+        baselines.erase(oldest);
+    }
+}
+
+void FleetAggregator::publishFeed() {
+    std::string message;
+    {
+        std::lock_guard<std::mutex> lock(stateMutex);
+        if (!feedDirty) {
+            return;
+        }
+        message = renderFeed();
+        feedActivities.clear();
+        feedDirty = false;
+    }
+    
+    // The listener may block on a slow dashboard, so it is never called with the state locked
+    if (listener) {
+        listener(message);
+    }
+}
+
+std::string FleetAggregator::renderFeed() {
+    static const char* const pauseNames[] = {"collection", "optimization", "defragmentation"};
+    
+    FleetTotals current = currentTotals();
+    
+    Json::Value instanceList(Json::arrayValue);
+    for (const auto& entry : instances) {
+        const FleetInstance& instance = entry.second;
+        Json::Value value;
+        value["id"] = instanceIdString(instance.instanceId);
+        value["pid"] = instance.pid;
+        value["name"] = instance.name;
+        value["connected"] = instance.connected;
+        if (instance.hasStats) {
+            value["totalMemory"] = static_cast<Json::UInt64>(instance.stats.totalMemory);
+            value["usedMemory"] = static_cast<Json::UInt64>(instance.stats.usedMemory);
+            value["freeMemory"] = static_cast<Json::UInt64>(instance.stats.freeMemory);
+            value["fragmentation"] = instance.stats.fragmentation;
+            value["pressureLevel"] = instance.stats.pressureLevel;
+            value["gcRuns"] = static_cast<Json::UInt64>(instance.stats.gcRuns);
+        }
+        instanceList.append(value);
+    }
+    
+    Json::Value totalsValue;
+    totalsValue["instances"] = static_cast<Json::UInt64>(current.instances);
+    totalsValue["connectedInstances"] = static_cast<Json::UInt64>(current.connectedInstances);
+    totalsValue["totalMemory"] = static_cast<Json::UInt64>(current.totalMemory);
+    totalsValue["usedMemory"] = static_cast<Json::UInt64>(current.usedMemory);
+    totalsValue["freeMemory"] = static_cast<Json::UInt64>(current.freeMemory);
+    totalsValue["pressureLevel"] = current.maxPressureLevel;
+    totalsValue["gcRuns"] = static_cast<Json::UInt64>(current.gcRuns);
+    totalsValue["memoryReclaimed"] = static_cast<Json::UInt64>(current.memoryReclaimed);
+    totalsValue["releasedMemory"] = static_cast<Json::UInt64>(current.releasedMemory);
+    
+    Json::Value bounds(Json::arrayValue);
+    for (double bound : PauseHistogram::BUCKET_BOUNDS_SECONDS) {
+        bounds.append(bound);
+    }
+    Json::Value pauses;
+    pauses["bucketBounds"] = bounds;
+    for (size_t i = 0; i < current.pauses.size(); ++i) {
+        pauses[pauseNames[i]] = histogramJson(current.pauses[i]);
+    }
+    
+    Json::Value activityList(Json::arrayValue);
+    for (const FleetActivity& activity : feedActivities) {
+        Json::Value value;
+        value["instance"] = instanceIdString(activity.instanceId);
+        value["id"] = activity.id;
+        value["algorithmId"] = activity.algorithmId;
+        value["timestamp"] = static_cast<Json::Int64>(activity.timestampMs);
+        value["duration"] = activity.durationMs;
+        value["memoryReclaimed"] = static_cast<Json::UInt64>(activity.memoryReclaimed);
+        value["objectsCollected"] = activity.objectsCollected;
+        value["cpuImpact"] = activity.cpuImpact;
+        value["pauseMicros"] = static_cast<Json::UInt64>(activity.pauseMicros);
+        value["referenceProcessingMicros"] = static_cast<Json::UInt64>(activity.referenceProcessingMicros);
+        activityList.append(value);
+    }
+    
+    Json::Value response;
+    response["type"] = "fleetUpdate";
+    response["sequence"] = static_cast<Json::UInt64>(++feedSequence);
+    response["totals"] = totalsValue;
+    response["pauseHistograms"] = pauses;
+    response["instances"] = instanceList;
+    response["activities"] = activityList;
+    
+    Json::FastWriter writer;
+    return writer.write(response);
+}
@@ -0,0 +1,113 @@
+#ifndef FLEET_AGGREGATOR_H
+#define FLEET_AGGREGATOR_H
+
+#include "fleet_protocol.h"
+#include <deque>
+
+// Fleet instance: the aggregator's view of one publishing MemoryManager
+struct FleetInstance {
+    uint64_t instanceId;
+    uint32_t pid;
+    std::string name;
+    bool connected;
+    bool hasStats;
+    FleetStats stats; // Latest snapshot
+    std::chrono::steady_clock::time_point lastSeen;
+};
+
+// Fleet totals: gauges summed over connected instances, counters and
+// histograms summed over every instance seen
+struct FleetTotals {
+    size_t instances;
+    size_t connectedInstances;
+    uint64_t totalMemory;
+    uint64_t usedMemory;
+    uint64_t freeMemory;
+    uint8_t maxPressureLevel;
+    uint64_t gcRuns;
+    uint64_t memoryReclaimed;
+    uint64_t releasedMemory;
+    std::array<FleetHistogram, 3> pauses; // Indexed by PauseType
+};
+
+// Fleet Aggregator class
+// Collects stats and activity streams from many local MemoryManager
+// instances over a Unix domain socket and serves them to the dashboard as
+// one feed, so watching a whole fleet costs the dashboard a single
+// connection. One thread polls every socket. Each stats frame is merged as
+// a delta against that instance's previous frame, so fleet counters and
+// histograms are updated incrementally instead of re-summed per feed.
+class FleetAggregator {
+public:
+    static constexpr std::chrono::milliseconds DEFAULT_FEED_INTERVAL{1000};
+    static constexpr size_t MAX_CONNECTIONS = 1024; // Further connections are closed on accept
+    static constexpr size_t MAX_RECENT_ACTIVITIES = 1000;
+    // Disconnected instances stay in the feed this long, so a restart shows up as a gap, not a vanishing row
+    static constexpr std::chrono::seconds INSTANCE_EXPIRY{60};
+    // Expired instances leave their last snapshot behind as the delta baseline for a late reconnect;
+    // past this many, the longest-unseen baselines are dropped
+    static constexpr size_t MAX_BASELINES = 4096;
+    
+    // Receives each feed message, a JSON "fleetUpdate"; called on the aggregator thread
+    using FeedListener = std::function<void(const std::string&)>;
+    
+    FleetAggregator(const std::string& socketPath, FeedListener listener,
+                    std::chrono::milliseconds feedInterval = DEFAULT_FEED_INTERVAL);
+    ~FleetAggregator();
+    
+    FleetAggregator(const FleetAggregator&) = delete;
+    FleetAggregator& operator=(const FleetAggregator&) = delete;
+    
+    // Binds the socket, replacing a stale one, and starts the aggregator thread; false if it cannot listen
+    bool start();
+    void stop();
+    
+    FleetTotals getTotals() const;
+    std::vector<FleetInstance> getInstances() const;
+    // Newest first, across all instances
+    std::vector<FleetActivity> getRecentActivities(size_t limit = 20) const;
+    
+private:
+    struct Connection {
+        int fd;
+        std::string input; // Bytes received but not yet parsed into whole frames
+        bool identified;   // HELLO received
+        uint64_t instanceId;
+    };
+    
+    void aggregatorThread();
+    void acceptConnections();
+    // False once the connection is closed or sent a malformed frame
+    bool readConnection(Connection& connection);
+    bool handleFrame(Connection& connection, uint8_t type, const char* payload, size_t size);
+    void closeConnection(Connection& connection);
+    // Caller holds stateMutex
+    void mergeStats(FleetInstance& instance, const FleetStats& stats);
+    FleetTotals currentTotals() const;
+    // Expired instances keep their last snapshot in baselines
+    void expireInstances(std::chrono::steady_clock::time_point now);
+    void publishFeed();
+    std::string renderFeed();
+    
+    std::string socketPath;
+    FeedListener listener;
+    std::chrono::milliseconds feedInterval;
+    
+    int listenFd;
+    int wakeFds[2]; // Self-pipe that stop() writes to
+    std::atomic<bool> running;
+    std::thread thread;
+    std::vector<Connection> connections; // Aggregator thread only
+    
+    mutable std::mutex stateMutex;
+    std::map<uint64_t, FleetInstance> instances;
+    std::map<uint64_t, FleetInstance> baselines; // Expired instances that had sent stats
+    FleetTotals totals;
+    std::deque<FleetActivity> recentActivities; // Newest first
+    std::vector<FleetActivity> feedActivities;  // Arrived since the last feed
+    bool feedDirty;
+    uint64_t feedSequence;
+    std::vector<FleetActivity> decodedActivities; // Reused by handleFrame
+};
+
+#endif // FLEET_AGGREGATOR_H
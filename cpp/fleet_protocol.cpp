@@ -0,0 +1,307 @@
+#include "fleet_protocol.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace {
+
+void putVarint(std::string& buffer, uint64_t value) {
+    while (value >= 0x80) {
+        buffer.push_back(static_cast<char>((value & 0x7f) | 0x80));
+        value >>= 7;
+    }
+    buffer.push_back(static_cast<char>(value));
+}
+
+// Signed fields are zigzag-encoded so small negative values stay short
+void putSigned(std::string& buffer, int64_t value) {
+    putVarint(buffer, (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63));
+}
+
+void putFloat(std::string& buffer, float value) {
+    uint32_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    for (int i = 0; i < 4; ++i) {
+        buffer.push_back(static_cast<char>(bits >> (8 * i)));
+    }
+}
+
+// Reserves the header; endFrame() fills in the length once the payload is written
+size_t beginFrame(std::string& buffer, FleetMessageType type) {
+    size_t start = buffer.size();
+    buffer.push_back(static_cast<char>(type));
+    buffer.append(4, '\0');
+    return start;
+}
+
+void endFrame(std::string& buffer, size_t start) {
+    uint32_t payloadSize = static_cast<uint32_t>(buffer.size() - start - FleetProtocol::HEADER_SIZE);
+    for (int i = 0; i < 4; ++i) {
+        buffer[start + 1 + i] = static_cast<char>(payloadSize >> (8 * i));
+    }
+}
+
+// Bounds-checked payload reader; once a read fails every later read fails too
+class PayloadReader {
+public:
+    PayloadReader(const char* data, size_t size)
+        : data(reinterpret_cast<const unsigned char*>(data)), size(size), position(0), failed(false) {}
+    
+    uint64_t varint() {
+        uint64_t value = 0;
+        for (int shift = 0; shift < 64; shift += 7) {
+            if (failed || position >= size) {
+                break;
+            }
+            unsigned char byte = data[position++];
+            value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+            if (!(byte & 0x80)) {
+                return value;
+            }
+        }
+        failed = true;
+        return 0;
+    }
+    
+    int64_t signedVarint() {
+        uint64_t value = varint();
+        return static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1);
+    }
+    
+    float floating() {
+        if (failed || size - position < 4) {
+            failed = true;
+            return 0.0f;
+        }
+        uint32_t bits = 0;
+        for (int i = 0; i < 4; ++i) {
+            bits |= static_cast<uint32_t>(data[position++]) << (8 * i);
+        }
+        float value;
+        std::memcpy(&value, &bits, sizeof(value));
+        return value;
+    }
+    
+    bool string(std::string& value, size_t maxLength) {
+        uint64_t length = varint();
+        if (failed || length > maxLength || length > size - position) {
+            failed = true;
+            return false;
+        }
+        value.assign(reinterpret_cast<const char*>(data + position), static_cast<size_t>(length));
+        position += static_cast<size_t>(length);
+        return true;
+    }
+    
+    // True when every read succeeded and the whole payload was consumed
+    bool complete() const {
+        return !failed && position == size;
+    }
+    
+    bool ok() const {
+        return !failed;
+    }
+    
+private:
+    const unsigned char* data;
+    size_t size;
+    size_t position;
+    bool failed;
+};
+
+int64_t toMilliseconds(std::chrono::system_clock::time_point time) {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(time.time_since_epoch()).count();
+}
+
+} // namespace
+
+// FleetHistogram implementation
+FleetHistogram FleetHistogram::capture(const PauseHistogram& histogram) {
+    FleetHistogram result;
+    // Collections may record while this runs, so the fields can be a pause or two apart
+    result.count = histogram.getCount();
+    result.sumMicros = static_cast<uint64_t>(std::llround(histogram.getSumSeconds() * 1000000.0));
+    
+    uint64_t previous = 0;
+    for (size_t i = 0; i < PauseHistogram::BUCKET_COUNT; ++i) {
+        uint64_t cumulative = histogram.getCumulativeCount(i);
+        result.buckets[i] = cumulative - std::min(cumulative, previous);
+        previous = std::max(previous, cumulative);
+    }
+    return result;
+}
+
+void FleetHistogram::add(const FleetHistogram& other) {
+    count += other.count;
+    sumMicros += other.sumMicros;
+    for (size_t i = 0; i < buckets.size(); ++i) {
+        buckets[i] += other.buckets[i];
+    }
+}
+
+FleetHistogram FleetHistogram::since(const FleetHistogram& previous) const {
+    if (count < previous.count) {
+        return *this;
+    }
+    
+    FleetHistogram delta;
+    delta.count = count - previous.count;
+    delta.sumMicros = sumMicros - std::min(sumMicros, previous.sumMicros);
+    for (size_t i = 0; i < buckets.size(); ++i) {
+        delta.buckets[i] = buckets[i] - std::min(buckets[i], previous.buckets[i]);
+    }
+    return delta;
+}
+
+// FleetStats implementation
+FleetStats FleetStats::capture(const MemoryManager& manager) {
+    FleetStats stats;
+    stats.timestampMs = static_cast<uint64_t>(toMilliseconds(std::chrono::system_clock::now()));
+    stats.totalMemory = manager.getTotalMemory();
+    stats.usedMemory = manager.getUsedMemory();
+    stats.freeMemory = manager.getFreeMemory();
+    stats.fragmentation = manager.getFragmentation();
+    stats.pressureLevel = static_cast<uint8_t>(manager.getMemoryPressureLevel());
+    stats.gcRuns = static_cast<uint64_t>(manager.getGcRunsToday());
+    stats.memoryReclaimed = manager.getMemoryReclaimedTotal();
+    stats.releasedMemory = manager.getReleasedMemoryTotal();
+    for (size_t i = 0; i < stats.pauses.size(); ++i) {
+        stats.pauses[i] = FleetHistogram::capture(manager.getPauseHistogram(static_cast<PauseType>(i)));
+    }
+    return stats;
+}
+
+// FleetActivity implementation
+FleetActivity FleetActivity::capture(const GcActivity& activity) {
+    return FleetActivity{0, activity.getId(), activity.getAlgorithmId(), toMilliseconds(activity.getTimestamp()),
+                         activity.getDurationMs(), activity.getMemoryReclaimed(), activity.getObjectsCollected(),
+                         activity.getCpuImpact(), static_cast<uint64_t>(activity.getPauseTime().count()),
+                         static_cast<uint64_t>(activity.getReferenceProcessingTime().count())};
+}
+
+// FleetProtocol implementation
+void FleetProtocol::encodeHello(std::string& buffer, const FleetHello& hello) {
+    size_t start = beginFrame(buffer, FleetMessageType::HELLO);
+    putVarint(buffer, VERSION);
+    putVarint(buffer, hello.instanceId);
+    putVarint(buffer, hello.pid);
+    size_t nameLength = std::min(hello.name.size(), MAX_NAME_LENGTH);
+    putVarint(buffer, nameLength);
+    buffer.append(hello.name, 0, nameLength);
+    endFrame(buffer, start);
+}
+
+void FleetProtocol::encodeStats(std::string& buffer, const FleetStats& stats) {
+    size_t start = beginFrame(buffer, FleetMessageType::STATS);
+    putVarint(buffer, stats.timestampMs);
+    putVarint(buffer, stats.totalMemory);
+    putVarint(buffer, stats.usedMemory);
+    putVarint(buffer, stats.freeMemory);
+    putFloat(buffer, stats.fragmentation);
+    putVarint(buffer, stats.pressureLevel);
+    putVarint(buffer, stats.gcRuns);
+    putVarint(buffer, stats.memoryReclaimed);
+    putVarint(buffer, stats.releasedMemory);
+    for (const FleetHistogram& histogram : stats.pauses) {
+        putVarint(buffer, histogram.count);
+        putVarint(buffer, histogram.sumMicros);
+        for (uint64_t bucket : histogram.buckets) {
+            putVarint(buffer, bucket);
+        }
+    }
+    endFrame(buffer, start);
+}
+
+void FleetProtocol::encodeActivities(std::string& buffer, const FleetActivity* activities, size_t count) {
+    // Larger batches are split so every frame stays under MAX_PAYLOAD_SIZE
+    for (size_t first = 0; first < count; first += MAX_ACTIVITIES_PER_FRAME) {
+        size_t batch = std::min(count - first, MAX_ACTIVITIES_PER_FRAME);
+        size_t start = beginFrame(buffer, FleetMessageType::ACTIVITIES);
+        putVarint(buffer, batch);
+        for (size_t i = first; i < first + batch; ++i) {
+            const FleetActivity& activity = activities[i];
+            putSigned(buffer, activity.id);
+            putSigned(buffer, activity.algorithmId);
+            putSigned(buffer, activity.timestampMs);
+            putSigned(buffer, activity.durationMs);
+            putVarint(buffer, activity.memoryReclaimed);
+            putSigned(buffer, activity.objectsCollected);
+            putFloat(buffer, activity.cpuImpact);
+            putVarint(buffer, activity.pauseMicros);
+            putVarint(buffer, activity.referenceProcessingMicros);
+        }
+        endFrame(buffer, start);
+    }
+}
+
+bool FleetProtocol::decodeHeader(const char* data, uint8_t& type, uint32_t& payloadSize) {
+    const unsigned char* bytes = reinterpret_cast<const unsigned char*>(data);
+    type = bytes[0];
+    payloadSize = 0;
+    for (int i = 0; i < 4; ++i) {
+        payloadSize |= static_cast<uint32_t>(bytes[1 + i]) << (8 * i);
+    }
+    return payloadSize <= MAX_PAYLOAD_SIZE;
+}
+
+bool FleetProtocol::decodeHello(const char* data, size_t size, FleetHello& hello) {
+    PayloadReader reader(data, size);
+    if (reader.varint() != VERSION) {
+        return false;
+    }
+    hello.instanceId = reader.varint();
+    hello.pid = static_cast<uint32_t>(reader.varint());
+    reader.string(hello.name, MAX_NAME_LENGTH);
+    return reader.complete();
+}
+
+bool FleetProtocol::decodeStats(const char* data, size_t size, FleetStats& stats) {
+    PayloadReader reader(data, size);
+    stats.timestampMs = reader.varint();
+    stats.totalMemory = reader.varint();
+    stats.usedMemory = reader.varint();
+    stats.freeMemory = reader.varint();
+    stats.fragmentation = reader.floating();
+    stats.pressureLevel = static_cast<uint8_t>(reader.varint());
+    stats.gcRuns = reader.varint();
+    stats.memoryReclaimed = reader.varint();
+    stats.releasedMemory = reader.varint();
+    for (FleetHistogram& histogram : stats.pauses) {
+        histogram.count = reader.varint();
+        histogram.sumMicros = reader.varint();
+        for (uint64_t& bucket : histogram.buckets) {
+            bucket = reader.varint();
+        }
+    }
+    return reader.complete();
+}
+
+bool FleetProtocol::decodeActivities(const char* data, size_t size, std::vector<FleetActivity>& activities) {
+    PayloadReader reader(data, size);
+    uint64_t count = reader.varint();
+    if (count > MAX_ACTIVITIES_PER_FRAME) {
+        return false;
+    }
+    
+    size_t first = activities.size();
+    for (uint64_t i = 0; i < count && reader.ok(); ++i) {
+        FleetActivity activity;
+        activity.instanceId = 0;
+        activity.id = static_cast<int>(reader.signedVarint());
+        activity.algorithmId = static_cast<int>(reader.signedVarint());
+        activity.timestampMs = reader.signedVarint();
+        activity.durationMs = static_cast<int>(reader.signedVarint());
+        activity.memoryReclaimed = reader.varint();
+        activity.objectsCollected = static_cast<int>(reader.signedVarint());
+        activity.cpuImpact = reader.floating();
+        activity.pauseMicros = reader.varint();
+        activity.referenceProcessingMicros = reader.varint();
+        activities.push_back(activity);
+    }
+    
+    if (!reader.complete()) {
+        activities.resize(first);
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,105 @@
+#ifndef FLEET_PROTOCOL_H
+#define FLEET_PROTOCOL_H
+
+#include "memory_manager.h"
+
+// Fleet protocol, spoken over a Unix stream socket from each instance to the aggregator.
+// Every frame is a 5-byte header followed by its payload:
+//   uint8  type
+//   uint32 payload length, little-endian
+// Integers in payloads are LEB128 varints and floats are 4-byte little-endian IEEE 754,
+// so mostly-empty histograms and small counters cost a byte or two each.
+//   HELLO:      version, instance id, pid, name (varint length + bytes)
+//   STATS:      timestamp ms, total/used/free bytes, fragmentation, pressure level,
+//               gc runs, reclaimed bytes, released bytes, then per pause type:
+//               count, sum in microseconds, BUCKET_COUNT bucket counts
+//   ACTIVITIES: activity count, then per activity: id, algorithm id, timestamp ms,
+//               duration ms, reclaimed bytes, objects collected, cpu impact,
+//               pause and reference-processing time in microseconds
+// Counters and histograms are cumulative since the instance started, so a lost or
+// repeated STATS frame never skews the aggregator's sums.
+
+// Fleet message type
+enum class FleetMessageType : uint8_t {
+    HELLO = 1,
+    STATS = 2,
+    ACTIVITIES = 3
+};
+
+// Fleet histogram: raw (not cumulative) bucket counts, so histograms merge by addition
+struct FleetHistogram {
+    uint64_t count;
+    uint64_t sumMicros;
+    std::array<uint64_t, PauseHistogram::BUCKET_COUNT> buckets;
+    
+    static FleetHistogram capture(const PauseHistogram& histogram);
+    void add(const FleetHistogram& other);
+    // What was recorded after previous; a histogram that went backwards was reset, so all of it is new
+    FleetHistogram since(const FleetHistogram& previous) const;
+};
+
+// Fleet stats: one instance's gauges, counters and pause histograms
+struct FleetStats {
+    uint64_t timestampMs;
+    uint64_t totalMemory;
+    uint64_t usedMemory;
+    uint64_t freeMemory;
+    float fragmentation;
+    uint8_t pressureLevel;
+    uint64_t gcRuns;
+    uint64_t memoryReclaimed;
+    uint64_t releasedMemory;
+    std::array<FleetHistogram, 3> pauses; // Indexed by PauseType
+    
+    static FleetStats capture(const MemoryManager& manager);
+};
+
+// Fleet hello: first frame on every connection
+struct FleetHello {
+    uint64_t instanceId; // Random per process, so reconnects are recognised and pids may repeat across hosts
+    uint32_t pid;
+    std::string name;
+};
+
+// Fleet activity: one GC activity, tagged with its instance by the aggregator
+struct FleetActivity {
+    uint64_t instanceId;
+    int id;
+    int algorithmId;
+    int64_t timestampMs;
+    int durationMs;
+    uint64_t memoryReclaimed;
+    int objectsCollected;
+    float cpuImpact;
+    uint64_t pauseMicros;
+    uint64_t referenceProcessingMicros;
+    
+    static FleetActivity capture(const GcActivity& activity);
+};
+
+// Fleet Protocol class
+// Encodes and decodes fleet frames. Encoders append to a caller-owned buffer
+// so publishers reuse its capacity; decoders reject truncated or oversized
+// payloads instead of trusting the peer.
+class FleetProtocol {
+public:
+    static constexpr uint32_t VERSION = 2; // 2 added pause and reference-processing time to ACTIVITIES
+    static constexpr size_t HEADER_SIZE = 5;
+    static constexpr uint32_t MAX_PAYLOAD_SIZE = 64 * 1024;
+    static constexpr size_t MAX_ACTIVITIES_PER_FRAME = 256;
+    static constexpr size_t MAX_NAME_LENGTH = 256;
+    
+    static void encodeHello(std::string& buffer, const FleetHello& hello);
+    static void encodeStats(std::string& buffer, const FleetStats& stats);
+    static void encodeActivities(std::string& buffer, const FleetActivity* activities, size_t count);
+    
+    // Reads a frame header; false if the payload length is over MAX_PAYLOAD_SIZE
+    static bool decodeHeader(const char* data, uint8_t& type, uint32_t& payloadSize);
+    // Payload decoders; false on a malformed payload
+    static bool decodeHello(const char* data, size_t size, FleetHello& hello);
+    static bool decodeStats(const char* data, size_t size, FleetStats& stats);
+    // Appends to activities; instanceId is left at 0 for the caller to fill in
+    static bool decodeActivities(const char* data, size_t size, std::vector<FleetActivity>& activities);
+};
+
+#endif // FLEET_PROTOCOL_H
@@ -0,0 +1,167 @@
+#include "fleet_publisher.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <random>
+
+#if defined(_WIN32)
+#define FLEET_USE_UNIX_SOCKETS 0
+#else
+#define FLEET_USE_UNIX_SOCKETS 1
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <unistd.h>
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0 // BSDs have no per-call flag; SIGPIPE is left to the host
+#endif
+#endif
+
+// FleetPublisher implementation
+FleetPublisher::FleetPublisher(const MemoryManager& manager, const std::string& socketPath, const std::string& name,
+                               std::chrono::milliseconds interval)
+    : manager(manager), socketPath(socketPath), name(name), interval(interval),
+      socketFd(-1), connected(false), lastActivityId(0), stopping(false) {
+    std::random_device device;
+    instanceId = (static_cast<uint64_t>(device()) << 32) | device();
+}
+
+FleetPublisher::~FleetPublisher() {
+    stop();
+}
+
+void FleetPublisher::start() {
+    if (thread.joinable()) {
+        return;
+    }
+    stopping = false;
+    thread = std::thread(&FleetPublisher::publishThread, this);
+}
+
+void FleetPublisher::stop() {
+    {
+        std::lock_guard<std::mutex> lock(stopMutex);
+        stopping = true;
+    }
+    stopCondition.notify_all();
+    
+    if (thread.joinable()) {
+        thread.join();
+    }
+}
+
+bool FleetPublisher::isConnected() const {
+    return connected;
+}
+
+uint64_t FleetPublisher::getInstanceId() const {
+    return instanceId;
+}
+
+void FleetPublisher::publishThread() {
+    std::unique_lock<std::mutex> lock(stopMutex);
+    while (!stopping) {
+        lock.unlock();
+        // A failed connect or send is retried on the next tick rather than in a tight loop
+        if (socketFd >= 0 || connectToAggregator()) {
+            if (!publish()) {
+                disconnect();
+            }
+        }
+        lock.lock();
+        stopCondition.wait_for(lock, interval, [this]() { return stopping; });
+    }
+    lock.unlock();
+    disconnect();
+}
+
+bool FleetPublisher::connectToAggregator() {
+#if FLEET_USE_UNIX_SOCKETS
+    sockaddr_un address;
+    std::memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    if (socketPath.size() >= sizeof(address.sun_path)) {
+        return false;
+    }
+    std::memcpy(address.sun_path, socketPath.c_str(), socketPath.size());
+    
+    socketFd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (socketFd < 0) {
+        return false;
+    }
+    if (connect(socketFd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0) {
+        disconnect();
+        return false;
+    }
+    
+    // A stalled aggregator costs this thread at most SEND_TIMEOUT per tick
+    timeval timeout{static_cast<time_t>(SEND_TIMEOUT.count() / 1000),
+                    static_cast<suseconds_t>(SEND_TIMEOUT.count() % 1000 * 1000)};
+    setsockopt(socketFd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+    
+    buffer.clear();
+    FleetProtocol::encodeHello(buffer, FleetHello{instanceId, static_cast<uint32_t>(getpid()), name});
+    if (!sendBuffer()) {
+        disconnect();
+        return false;
+    }
+    connected = true;
+    return true;
+#else
+    return false;
+#endif
+}
+
+void FleetPublisher::disconnect() {
+#if FLEET_USE_UNIX_SOCKETS
+    if (socketFd >= 0) {
+        close(socketFd);
+        socketFd = -1;
+    }
+#endif
+    connected = false;
+}
+
+bool FleetPublisher::publish() {
+    buffer.clear();
+    FleetProtocol::encodeStats(buffer, FleetStats::capture(manager));
+    
+    // Activities come newest first; ids only grow, so stop at the last one already sent.
+    // More than MAX_ACTIVITIES_PER_FRAME collections in one interval drops the oldest.
+    newActivities.clear();
+    int newestId = lastActivityId;
+    for (const auto& activity : manager.getRecentActivities(FleetProtocol::MAX_ACTIVITIES_PER_FRAME)) {
+        if (activity->getId() <= lastActivityId) {
+            break;
+        }
+        newActivities.push_back(FleetActivity::capture(*activity));
+        newestId = std::max(newestId, activity->getId());
+    }
+    std::reverse(newActivities.begin(), newActivities.end());
+    FleetProtocol::encodeActivities(buffer, newActivities.data(), newActivities.size());
+    
+    if (!sendBuffer()) {
+        return false;
+    }
+    lastActivityId = newestId;
+    return true;
+}
+
+bool FleetPublisher::sendBuffer() {
+#if FLEET_USE_UNIX_SOCKETS
+    size_t sent = 0;
+    while (sent < buffer.size()) {
+        ssize_t written = send(socketFd, buffer.data() + sent, buffer.size() - sent, MSG_NOSIGNAL);
+        if (written < 0 && errno == EINTR) {
+            continue;
+        }
+        if (written <= 0) {
+            return false;
+        }
+        sent += static_cast<size_t>(written);
+    }
+    return true;
+#else
+    return false;
+#endif
+}
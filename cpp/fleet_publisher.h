@@ -0,0 +1,54 @@
+#ifndef FLEET_PUBLISHER_H
+#define FLEET_PUBLISHER_H
+
+#include "fleet_protocol.h"
+
+// Fleet Publisher class
+// Streams one MemoryManager's stats and new GC activities to a fleet
+// aggregator over a Unix domain socket. Runs on its own thread and reads
+// only the manager's lock-free getters and its activity list, so it never
+// waits on a collection. Reconnects quietly if the aggregator restarts.
+class FleetPublisher {
+public:
+    static constexpr std::chrono::milliseconds DEFAULT_INTERVAL{1000};
+    static constexpr std::chrono::milliseconds SEND_TIMEOUT{1000};
+    
+    FleetPublisher(const MemoryManager& manager, const std::string& socketPath, const std::string& name,
+                   std::chrono::milliseconds interval = DEFAULT_INTERVAL);
+    ~FleetPublisher();
+    
+    FleetPublisher(const FleetPublisher&) = delete;
+    FleetPublisher& operator=(const FleetPublisher&) = delete;
+    
+    void start();
+    void stop();
+    bool isConnected() const;
+    uint64_t getInstanceId() const;
+    
+private:
+    void publishThread();
+    bool connectToAggregator();
+    void disconnect();
+    // Sends a stats frame and every activity newer than the last one sent
+    bool publish();
+    bool sendBuffer();
+    
+    const MemoryManager& manager;
+    std::string socketPath;
+    std::string name;
+    std::chrono::milliseconds interval;
+    uint64_t instanceId;
+    
+    int socketFd;
+    std::atomic<bool> connected;
+    int lastActivityId;
+    std::string buffer; // Reused for every frame batch
+    std::vector<FleetActivity> newActivities;
+    
+    std::mutex stopMutex;
+    std::condition_variable stopCondition;
+    bool stopping;
+    std::thread thread;
+};
+
+#endif // FLEET_PUBLISHER_H
@@ -0,0 +1,177 @@
+#include "gc_job_queue.h"
+#include <algorithm>
+
+// GcJobQueue implementation
+GcJobQueue::GcJobQueue(Runner runner, Listener listener, size_t workerCount)
+    : runner(std::move(runner)), listener(std::move(listener)), nextJobId(1), stopping(false) {
+    workerCount = std::max<size_t>(1, workerCount);
+    for (size_t i = 0; i < workerCount; ++i) {
+        workers.emplace_back(&GcJobQueue::workerLoop, this);
+    }
+}
+
+GcJobQueue::~GcJobQueue() {
+    shutdown();
+}
+
+uint64_t GcJobQueue::submit(GcJobType type, int priority) {
+    GcJobEvent event;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        
+        // A job of the same type that has not started yet serves this request too
+        auto existing = std::find_if(pending.begin(), pending.end(), [type](const std::shared_ptr<Job>& job) {
+            return job->type == type;
+        });
+        
+        if (existing != pending.end()) {
+            Job& job = **existing;
+            job.priority = std::max(job.priority, priority);
+            job.requests++;
+            event = makeEvent(job, GcJobState::QUEUED, 0.0f, 0);
+        } else {
+            auto job = std::make_shared<Job>();
+            job->id = nextJobId++;
+            job->type = type;
+            job->priority = priority;
+            job->requests = 1;
+            job->cancelRequested = false;
+            job->reportedProgress = 0.0f;
+            
+            if (stopping) {
+                event = makeEvent(*job, GcJobState::CANCELLED, 0.0f, 0);
+            } else {
+                pending.push_back(job);
+                condition.notify_one();
+                event = makeEvent(*job, GcJobState::QUEUED, 0.0f, 0);
+            }
+        }
+    }
+    
+    listener(event);
+    return event.jobId;
+}
+
+bool GcJobQueue::cancel(uint64_t jobId) {
+    GcJobEvent event;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        
+        auto queued = std::find_if(pending.begin(), pending.end(), [jobId](const std::shared_ptr<Job>& job) {
+            return job->id == jobId;
+        });
+        
+        if (queued == pending.end()) {
+            // A running job stops at its next progress report and its worker sends the event
+            auto active = std::find_if(running.begin(), running.end(), [jobId](const std::shared_ptr<Job>& job) {
+                return job->id == jobId;
+            });
+            if (active == running.end()) {
+                return false;
+            }
+            (*active)->cancelRequested = true;
+            return true;
+        }
+        
+        event = makeEvent(**queued, GcJobState::CANCELLED, 0.0f, 0);
+        pending.erase(queued);
+    }
+    
+    listener(event);
+    return true;
+}
+
+size_t GcJobQueue::getPendingCount() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return pending.size();
+}
+
+size_t GcJobQueue::getRunningCount() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return running.size();
+}
+
+void GcJobQueue::shutdown() {
+    std::vector<std::shared_ptr<Job>> dropped;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+        dropped.swap(pending);
+        for (auto& job : running) {
+            job->cancelRequested = true;
+        }
+    }
+    condition.notify_all();
+    
+    for (auto& worker : workers) {
+        if (worker.joinable()) {
+            worker.join();
+        }
+    }
+    
+    for (const auto& job : dropped) {
+        listener(makeEvent(*job, GcJobState::CANCELLED, 0.0f, 0));
+    }
+}
+
+void GcJobQueue::workerLoop() {
+    while (true) {
+        std::shared_ptr<Job> job;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            condition.wait(lock, [this]() { return stopping || !pending.empty(); });
+            if (stopping) {
+                return;
+            }
+            
+            // Highest priority first, oldest first among equals
+            auto next = std::max_element(pending.begin(), pending.end(),
+                [](const std::shared_ptr<Job>& a, const std::shared_ptr<Job>& b) {
+                    return a->priority < b->priority || (a->priority == b->priority && a->id > b->id);
+                });
+            job = *next;
+            pending.erase(next);
+            running.push_back(job);
+        }
+        
+        // Out of the pending list the job's fields no longer change, so events read them unlocked
+        listener(makeEvent(*job, GcJobState::RUNNING, 0.0f, 0));
+        
+        bool stopped = false;
+        GcProgressCallback progress = [this, &job, &stopped](float fraction) {
+            if (job->cancelRequested) {
+                stopped = true;
+                return false;
+            }
+            if (fraction - job->reportedProgress >= PROGRESS_STEP) {
+                job->reportedProgress = fraction;
+                listener(makeEvent(*job, GcJobState::RUNNING, fraction, 0));
+            }
+            return true;
+        };
+        
+        size_t memoryReclaimed = runner(job->type, progress);
+        
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            running.erase(std::find(running.begin(), running.end(), job));
+        }
+        
+        if (stopped) {
+            listener(makeEvent(*job, GcJobState::CANCELLED, job->reportedProgress, memoryReclaimed));
+        } else {
+            listener(makeEvent(*job, GcJobState::COMPLETED, 1.0f, memoryReclaimed));
+        }
+    }
+}
+
+GcJobEvent GcJobQueue::makeEvent(const Job& job, GcJobState state, float progress, size_t memoryReclaimed) const {
+    GcJobEvent event;
+    event.jobId = job.id;
+    event.type = job.type;
+    event.state = state;
+    event.progress = progress;
+    event.memoryReclaimed = memoryReclaimed;
+    event.requests = job.requests;
+    return event;
+}
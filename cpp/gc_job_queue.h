@@ -0,0 +1,87 @@
+#ifndef GC_JOB_QUEUE_H
+#define GC_JOB_QUEUE_H
+
+#include "memory_manager.h"
+
+// GC job type: the control commands that can be queued
+enum class GcJobType {
+    COLLECTION,
+    OPTIMIZATION,
+    DEFRAGMENTATION
+};
+
+// GC job state, reported in every job event
+enum class GcJobState {
+    QUEUED,
+    RUNNING,
+    COMPLETED,
+    CANCELLED
+};
+
+// GC job event: sent when a job is queued, makes progress, or finishes
+struct GcJobEvent {
+    uint64_t jobId;
+    GcJobType type;
+    GcJobState state;
+    float progress;
+    size_t memoryReclaimed;
+    int requests; // Identical requests coalesced into this job
+};
+
+// GC Job Queue class
+// Runs control commands on a small worker pool so callers return at once.
+// Pending jobs are ordered by priority, and a request for a job type that is
+// already waiting joins that job instead of queueing another run.
+class GcJobQueue {
+public:
+    static constexpr size_t DEFAULT_WORKER_COUNT = 2;
+    static constexpr float PROGRESS_STEP = 0.05f; // Smaller progress changes are not reported
+    
+    // Runs one job; the progress callback returns false once the job is cancelled
+    using Runner = std::function<size_t(GcJobType, const GcProgressCallback&)>;
+    // Called from worker threads and from submit()/cancel(), never with the queue locked
+    using Listener = std::function<void(const GcJobEvent&)>;
+    
+    GcJobQueue(Runner runner, Listener listener, size_t workerCount = DEFAULT_WORKER_COUNT);
+    ~GcJobQueue();
+    
+    GcJobQueue(const GcJobQueue&) = delete;
+    GcJobQueue& operator=(const GcJobQueue&) = delete;
+    
+    // Higher priorities run first; returns the id of the job that will serve the request
+    uint64_t submit(GcJobType type, int priority = 0);
+    // Drops a queued job or asks a running one to stop; false if the job is unknown or finished
+    bool cancel(uint64_t jobId);
+    size_t getPendingCount() const;
+    size_t getRunningCount() const;
+    
+    // Cancels everything and joins the workers; later submissions are cancelled on arrival
+    void shutdown();
+    
+private:
+    struct Job {
+        uint64_t id;
+        GcJobType type;
+        int priority;
+        int requests;
+        std::atomic<bool> cancelRequested;
+        float reportedProgress;
+    };
+    
+    void workerLoop();
+    GcJobEvent makeEvent(const Job& job, GcJobState state, float progress, size_t memoryReclaimed) const;
+    
+    Runner runner;
+    Listener listener;
+    
+    mutable std::mutex mutex;
+    std::condition_variable condition;
+    // Only a handful of jobs are ever pending, so a linear scan picks the next one
+    std::vector<std::shared_ptr<Job>> pending;
+    std::vector<std::shared_ptr<Job>> running;
+    std::vector<std::thread> workers;
+    uint64_t nextJobId;
+    bool stopping;
+};
+
+#endif // GC_JOB_QUEUE_H
@@ -0,0 +1,97 @@
+#ifndef GC_KERNELS_H
+#define GC_KERNELS_H
+
+#include "memory_manager.h"
+#include "allocation_profiler.h"
+#include <algorithm>
+
+// Reclaim policies: the share of unpinned active blocks each simulated algorithm finds dead
+struct MarkSweepPolicy {
+    static constexpr double RECLAIM_PROBABILITY = 0.30;
+};
+
+struct GenerationalPolicy {
+    static constexpr double RECLAIM_PROBABILITY = 0.40;
+};
+
+struct ReferenceCountingPolicy {
+    static constexpr double RECLAIM_PROBABILITY = 0.25;
+};
+
+struct ConcurrentGcPolicy {
+    static constexpr double RECLAIM_PROBABILITY = 0.35;
+};
+
+struct RegionEvacuationPolicy {
+    static constexpr double RECLAIM_PROBABILITY = 0.30;
+};
+
+// Priority traits: per-priority tuning folded into each kernel. Every priority reclaims at
+// its policy's rate for now; the specialisations are where a priority would change that.
+template <CollectionPriority Priority>
+struct PriorityTraits;
+
+template <>
+struct PriorityTraits<CollectionPriority::BALANCED> {
+    static constexpr double RECLAIM_SCALE = 1.0;
+};
+
+template <>
+struct PriorityTraits<CollectionPriority::SPEED> {
+    static constexpr double RECLAIM_SCALE = 1.0;
+};
+
+template <>
+struct PriorityTraits<CollectionPriority::MEMORY> {
+    static constexpr double RECLAIM_SCALE = 1.0;
+};
+
+// Sweep kernel
+// A fused scan-and-reclaim pass. The reclaim threshold is folded into an
+// integer at compile time, so each block costs a status load, a pinned check,
+// one generator step and, for the blocks it finds dead, a relaxed load of
+// their reference flags, then a CAS plus a relaxed load to see whether the
+// profiler sampled them. Dead blocks with weak references or a finalizer
+// stay active for the reference-processing phase.
+template <typename Policy, CollectionPriority Priority>
+size_t sweepKernel(std::vector<std::shared_ptr<MemoryBlock>>& blocks, SweepRandom& random,
+                   AllocationProfiler* profiler, std::vector<std::shared_ptr<MemoryBlock>>& discovered) {
+    constexpr double probability = std::min(1.0, Policy::RECLAIM_PROBABILITY * PriorityTraits<Priority>::RECLAIM_SCALE);
+    // Compared against the top 53 bits of the generator, which a double holds exactly
+    constexpr uint64_t threshold = static_cast<uint64_t>(probability * 9007199254740992.0);
+    
+    size_t memoryReclaimed = 0;
+    for (const auto& handle : blocks) {
+        MemoryBlock& block = *handle;
+        if (block.getStatus() != BlockStatus::ACTIVE || block.isPinned()) {
+            continue;
+        }
+        if ((random.next() >> 11) >= threshold) {
+            continue;
+        }
+        if (block.getReferenceFlags() != 0) {
+            discovered.push_back(handle);
+            continue;
+        }
+        if (block.compareAndSetStatus(BlockStatus::ACTIVE, BlockStatus::FREE)) {
+            memoryReclaimed += block.getSize();
+            if (profiler && block.isSampled()) {
+                profiler->recordFree(block);
+            }
+        }
+    }
+    
+    return memoryReclaimed;
+}
+
+// Every priority's kernel for one policy, in CollectionPriority order
+template <typename Policy>
+SweepKernels makeSweepKernels() {
+    return {{
+        &sweepKernel<Policy, CollectionPriority::BALANCED>,
+        &sweepKernel<Policy, CollectionPriority::SPEED>,
+        &sweepKernel<Policy, CollectionPriority::MEMORY>
+    }};
+}
+
+#endif // GC_KERNELS_H
@@ -0,0 +1,193 @@
+#include "heap_backing.h"
+#include <cerrno>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+
+#if defined(_WIN32)
+#define HEAP_BACKING_USE_MMAP 0
+#else
+#define HEAP_BACKING_USE_MMAP 1
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+// HeapBacking implementation
+HeapBacking::HeapBacking()
+    : base(nullptr), size(0), pageSize(4096), hugePages(false), lazyFree(false) {}
+
+HeapBacking::~HeapBacking() {
+#if HEAP_BACKING_USE_MMAP
+    if (base) {
+        munmap(base, size);
+    }
+#endif
+}
+
+bool HeapBacking::reserve(size_t size) {
+#if HEAP_BACKING_USE_MMAP
+    if (base || size == 0) {
+        return false;
+    }
+    
+    pageSize = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    size = (size + pageSize - 1) / pageSize * pageSize;
+    
+    // Over-reserve by one huge page so the start can be aligned for THP, then trim the slack
+    bool wantHugePages = size >= HUGE_PAGE_SIZE;
+    size_t mapSize = wantHugePages ? size + HUGE_PAGE_SIZE : size;
+    void* mapping = mmap(nullptr, mapSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if (mapping == MAP_FAILED) {
+        return false;
+    }
+    
+    char* start = static_cast<char*>(mapping);
+    if (wantHugePages) {
+        uintptr_t address = reinterpret_cast<uintptr_t>(start);
+        uintptr_t aligned = (address + HUGE_PAGE_SIZE - 1) & ~static_cast<uintptr_t>(HUGE_PAGE_SIZE - 1);
+        size_t head = aligned - address;
+        size_t tail = mapSize - head - size;
+        if (head > 0) {
+            munmap(start, head);
+        }
+        if (tail > 0) {
+            munmap(start + head + size, tail);
+        }
+        start += head;
+    }
+    
+    base = start;
+    this->size = size;
+
+#ifdef MADV_HUGEPAGE
+    // Best effort: THP may be disabled system-wide, in which case regular pages are used
+    hugePages = wantHugePages && madvise(base, size, MADV_HUGEPAGE) == 0;
+#endif
+
+#ifdef MADV_FREE
+    // MADV_FREE lets the kernel take pages back lazily, which is cheaper than an immediate unmap.
+    // Probe it once on the first page; kernels before 4.5 reject it with EINVAL.
+    lazyFree = madvise(base, pageSize, MADV_FREE) == 0;
+#endif
+    
+    return true;
+#else
+    (void)size;
+    return false;
+#endif
+}
+
+bool HeapBacking::isReserved() const {
+    return base != nullptr;
+}
+
+size_t HeapBacking::getSize() const {
+    return size;
+}
+
+bool HeapBacking::usesHugePages() const {
+    return hugePages;
+}
+
+bool HeapBacking::usesLazyFree() const {
+    return lazyFree;
+}
+
+void* HeapBacking::getAddress(size_t offset, size_t length) const {
+    if (!base || offset > size || length > size - offset) {
+        return nullptr;
+    }
+    return base + offset;
+}
+
+size_t HeapBacking::release(size_t offset, size_t length, bool immediate) {
+#if HEAP_BACKING_USE_MMAP
+    if (!getAddress(offset, length)) {
+        return 0;
+    }
+    
+    // Only pages that lie wholly inside the range; the partial pages at either end may hold live data
+    size_t first = (offset + pageSize - 1) / pageSize * pageSize;
+    size_t last = (offset + length) / pageSize * pageSize;
+    if (first >= last) {
+        return 0;
+    }
+    
+    int advice = MADV_DONTNEED;
+#ifdef MADV_FREE
+    if (lazyFree && !immediate) {
+        advice = MADV_FREE;
+    }
+#endif
+    
+    if (madvise(base + first, last - first, advice) != 0) {
+        return 0;
+    }
+    return last - first;
+#else
+    (void)offset;
+    (void)length;
+    (void)immediate;
+    return 0;
+#endif
+}
+
+size_t HeapBacking::releaseAll() {
+#if HEAP_BACKING_USE_MMAP
+    // A restore replaces the heap outright, so drop the pages immediately rather than lazily
+    if (!base || madvise(base, size, MADV_DONTNEED) != 0) {
+        return 0;
+    }
+    return size;
+#else
+    return 0;
+#endif
+}
+
+HeapResidency HeapBacking::readResidency(const std::string& smapsPath) const {
+    HeapResidency residency{false, 0, 0, 0};
+    if (!base) {
+        return residency;
+    }
+    
+    std::ifstream smaps(smapsPath);
+    if (!smaps) {
+        return residency;
+    }
+    residency.available = true;
+    
+    // Mapping lines look like "7f12a0000000-7f12c0000000 rw-p ..."; field lines like "Rss:  2048 kB"
+    uintptr_t reservationStart = reinterpret_cast<uintptr_t>(base);
+    uintptr_t reservationEnd = reservationStart + size;
+    bool inReservation = false;
+    
+    std::string line;
+    while (std::getline(smaps, line)) {
+        size_t colon = line.find(':');
+        size_t dash = line.find('-');
+        if (dash != std::string::npos && (colon == std::string::npos || dash < colon)) {
+            char* end = nullptr;
+            uintptr_t start = std::strtoull(line.c_str(), &end, 16);
+            if (end == line.c_str() + dash) {
+                uintptr_t stop = std::strtoull(line.c_str() + dash + 1, nullptr, 16);
+                inReservation = start < reservationEnd && stop > reservationStart;
+                continue;
+            }
+        }
+        
+        if (!inReservation || colon == std::string::npos) {
+            continue;
+        }
+        
+        size_t kilobytes = std::strtoull(line.c_str() + colon + 1, nullptr, 10);
+        if (line.compare(0, colon, "Rss") == 0) {
+            residency.rss += kilobytes * 1024;
+        } else if (line.compare(0, colon, "AnonHugePages") == 0) {
+            residency.anonHugePages += kilobytes * 1024;
+        } else if (line.compare(0, colon, "LazyFree") == 0) {
+            residency.lazyFree += kilobytes * 1024;
+        }
+    }
+    
+    return residency;
+}
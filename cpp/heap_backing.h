@@ -0,0 +1,56 @@
+#ifndef HEAP_BACKING_H
+#define HEAP_BACKING_H
+
+#include <cstddef>
+#include <string>
+
+// Heap residency: what the kernel reports for the reservation in /proc/self/smaps
+struct HeapResidency {
+    bool available;
+    size_t rss;
+    size_t anonHugePages;
+    size_t lazyFree; // Released with MADV_FREE but not yet reclaimed by the kernel
+};
+
+// Heap Backing class
+// One anonymous mmap reservation that block offsets map into. Free ranges go
+// back to the kernel with madvise, and large reservations ask for transparent
+// huge pages. Only whole pages inside a range are released, so neighbouring
+// blocks that share a page are never touched.
+class HeapBacking {
+public:
+    static constexpr size_t HUGE_PAGE_SIZE = 2 * 1024 * 1024;
+    
+    HeapBacking();
+    ~HeapBacking();
+    
+    HeapBacking(const HeapBacking&) = delete;
+    HeapBacking& operator=(const HeapBacking&) = delete;
+    
+    // False where anonymous mappings are unavailable or the reservation fails
+    bool reserve(size_t size);
+    bool isReserved() const;
+    size_t getSize() const;
+    bool usesHugePages() const;
+    bool usesLazyFree() const;
+    
+    // Nullptr unless [offset, offset + length) lies inside the reservation
+    void* getAddress(size_t offset, size_t length) const;
+    
+    // Hands the whole pages of [offset, offset + length) back to the kernel; returns the bytes released.
+    // immediate skips MADV_FREE, whose pages still count against the cgroup until the kernel reclaims them.
+    size_t release(size_t offset, size_t length, bool immediate = false);
+    size_t releaseAll();
+    
+    // Sums the smaps entries covering the reservation; available is false off Linux
+    HeapResidency readResidency(const std::string& smapsPath = "/proc/self/smaps") const;
+    
+private:
+    char* base;
+    size_t size;
+    size_t pageSize;
+    bool hugePages;
+    bool lazyFree;
+};
+
+#endif // HEAP_BACKING_H
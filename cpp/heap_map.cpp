@@ -0,0 +1,128 @@
+#include "heap_map.h"
+#include <algorithm>
+
+namespace {
+
+// Changed pixels this close together are sent as one range; a run costs less than a range header
+const uint32_t MERGE_GAP = 4;
+
+} // namespace
+
+// HeapMap implementation
+HeapMap::HeapMap(uint32_t width, uint64_t& versionCounter)
+    : width(width), versionCounter(versionCounter), version(0), oldestDiffVersion(0),
+      pixels(width, BlockStatus::FREE) {}
+
+uint32_t HeapMap::getWidth() const {
+    return width;
+}
+
+uint64_t HeapMap::getVersion() const {
+    return version;
+}
+
+std::chrono::steady_clock::time_point HeapMap::getLastRefresh() const {
+    return lastRefresh;
+}
+
+void HeapMap::refresh(const std::vector<BlockStatus>& newPixels, std::chrono::steady_clock::time_point now) {
+    lastRefresh = now;
+    
+    std::vector<DirtyRange> changed;
+    for (uint32_t i = 0; i < width; ++i) {
+        if (newPixels[i] == pixels[i]) {
+            continue;
+        }
+        
+        if (!changed.empty() && i - changed.back().end <= MERGE_GAP) {
+            changed.back().end = i + 1;
+        } else {
+            changed.push_back({0, i, i + 1});
+        }
+    }
+    
+    // The first refresh always produces a version, even for an all-free heap
+    if (changed.empty() && version != 0) {
+        return;
+    }
+    
+    // The first version's changes are against the blank map no client has, so diffs start after it
+    if (version == 0) {
+        oldestDiffVersion = versionCounter + 2;
+    }
+    
+    pixels = newPixels;
+    version = ++versionCounter;
+    
+    for (auto& range : changed) {
+        range.version = version;
+        history.push_back(range);
+    }
+    
+    while (history.size() > HISTORY_SIZE) {
+        oldestDiffVersion = history.front().version + 1;
+        history.pop_front();
+    }
+}
+
+HeapMapUpdate HeapMap::getUpdate(uint64_t sinceVersion) const {
+    HeapMapUpdate update;
+    update.version = version;
+    update.width = width;
+    update.full = false;
+    
+    if (sinceVersion == version) {
+        return update;
+    }
+    
+    if (sinceVersion != 0 && sinceVersion < version && sinceVersion + 1 >= oldestDiffVersion) {
+        // Union of every range dirtied after sinceVersion
+        std::vector<std::pair<uint32_t, uint32_t>> spans;
+        for (const auto& range : history) {
+            if (range.version > sinceVersion) {
+                spans.emplace_back(range.start, range.end);
+            }
+        }
+        std::sort(spans.begin(), spans.end());
+        
+        std::vector<std::pair<uint32_t, uint32_t>> merged;
+        uint32_t covered = 0;
+        for (const auto& span : spans) {
+            if (!merged.empty() && span.first <= merged.back().second + MERGE_GAP) {
+                merged.back().second = std::max(merged.back().second, span.second);
+            } else {
+                merged.push_back(span);
+            }
+        }
+        for (const auto& span : merged) {
+            covered += span.second - span.first;
+        }
+        
+        // Past half the map a full update is no bigger and simpler to apply
+        if (covered <= width / 2) {
+            for (const auto& span : merged) {
+                update.ranges.push_back(encodeRange(span.first, span.second));
+            }
+            return update;
+        }
+    }
+    
+    update.full = true;
+    update.ranges.push_back(encodeRange(0, width));
+    return update;
+}
+
+HeapMapRange HeapMap::encodeRange(uint32_t start, uint32_t end) const {
+    HeapMapRange range;
+    range.start = start;
+    
+    for (uint32_t i = start; i < end; ++i) {
+        if (!range.runs.empty() && range.runs.back().status == pixels[i]) {
+            range.runs.back().length++;
+        } else {
+            range.runs.push_back({pixels[i], 1});
+        }
+    }
+    
+    return range;
+}
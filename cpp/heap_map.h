@@ -0,0 +1,68 @@
+#ifndef HEAP_MAP_H
+#define HEAP_MAP_H
+
+#include "memory_manager.h"
+#include <deque>
+
+// Heap map run: consecutive pixels sharing the same dominant status
+struct HeapMapRun {
+    BlockStatus status;
+    uint32_t length;
+};
+
+// Heap map range: a span of pixels starting at start, covered exactly by its runs
+struct HeapMapRange {
+    uint32_t start;
+    std::vector<HeapMapRun> runs;
+};
+
+// Heap map update: either the full map or only the ranges that changed since a version
+struct HeapMapUpdate {
+    uint64_t version;
+    uint32_t width;
+    bool full;
+    std::vector<HeapMapRange> ranges;
+};
+
+// Heap Map class
+// Versioned picture of the heap at a fixed pixel width. Each pixel holds the
+// status covering most of its bytes; clients catch up from the version they
+// last saw with run-length-encoded dirty ranges.
+class HeapMap {
+public:
+    static constexpr size_t HISTORY_SIZE = 256; // Dirty ranges kept for incremental updates
+    
+    // Versions are drawn from versionCounter, which every map of one heap shares and the caller
+    // serialises; a version seen on another map, or on a map since dropped, is never taken for
+    // one of this map's and always gets a full update
+    HeapMap(uint32_t width, uint64_t& versionCounter);
+    
+    uint32_t getWidth() const;
+    uint64_t getVersion() const;
+    std::chrono::steady_clock::time_point getLastRefresh() const;
+    
+    // Replaces the pixels; the version only moves if something changed
+    void refresh(const std::vector<BlockStatus>& newPixels, std::chrono::steady_clock::time_point now);
+    
+    // Full map when sinceVersion is 0, unknown or too old to diff against
+    HeapMapUpdate getUpdate(uint64_t sinceVersion) const;
+    
+private:
+    struct DirtyRange {
+        uint64_t version;
+        uint32_t start;
+        uint32_t end;
+    };
+    
+    HeapMapRange encodeRange(uint32_t start, uint32_t end) const;
+    
+    uint32_t width;
+    uint64_t& versionCounter;
+    uint64_t version;
+    uint64_t oldestDiffVersion; // Diffs are available from this version onwards
+    std::vector<BlockStatus> pixels;
+    std::deque<DirtyRange> history;
+    std::chrono::steady_clock::time_point lastRefresh;
+};
+
+#endif // HEAP_MAP_H
@@ -0,0 +1,287 @@
+#include "heap_snapshot.h"
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <type_traits>
+
+#if defined(_WIN32)
+#define HEAP_SNAPSHOT_USE_MMAP 0
+#else
+#define HEAP_SNAPSHOT_USE_MMAP 1
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+static_assert(std::is_trivially_copyable<SnapshotHeader>::value, "snapshot records must be POD");
+static_assert(sizeof(SnapshotHeader) == 48, "snapshot header layout changed; bump FORMAT_VERSION");
+static_assert(sizeof(SnapshotSettings) == 16, "snapshot settings layout changed; bump FORMAT_VERSION");
+static_assert(sizeof(SnapshotStats) == 40, "snapshot stats layout changed; bump FORMAT_VERSION");
+static_assert(sizeof(SnapshotAlgorithm) == 16, "snapshot algorithm layout changed; bump FORMAT_VERSION");
+static_assert(sizeof(SnapshotBlock) == 24, "snapshot block layout changed; bump FORMAT_VERSION");
+
+namespace {
+
+const uint64_t FNV_OFFSET_BASIS = 14695981039346656037ULL;
+const uint64_t FNV_PRIME = 1099511628211ULL;
+
+uint64_t fnv1a(uint64_t hash, const void* bytes, size_t length) {
+    const unsigned char* p = static_cast<const unsigned char*>(bytes);
+    for (size_t i = 0; i < length; ++i) {
+        hash = (hash ^ p[i]) * FNV_PRIME;
+    }
+    return hash;
+}
+
+#if HEAP_SNAPSHOT_USE_MMAP
+// Writes all of length, retrying short writes and interrupted calls
+bool writeAll(int fd, const void* bytes, size_t length) {
+    const char* p = static_cast<const char*>(bytes);
+    while (length > 0) {
+        ssize_t written = ::write(fd, p, length);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        p += written;
+        length -= static_cast<size_t>(written);
+    }
+    return true;
+}
+
+// Flushes a directory's entries to stable storage
+bool syncPath(const std::string& path, int flags) {
+    int fd = ::open(path.c_str(), flags);
+    if (fd < 0) {
+        return false;
+    }
+    bool synced = fsync(fd) == 0;
+    ::close(fd);
+    return synced;
+}
+#endif
+
+} // namespace
+
+// HeapSnapshot implementation
+const char HeapSnapshot::MAGIC[8] = {'M', 'M', 'S', 'N', 'A', 'P', '\0', '\0'};
+
+HeapSnapshot::HeapSnapshot()
+    : settings(), stats(), arenaCount(0) {}
+
+SnapshotSettings& HeapSnapshot::getSettings() {
+    return settings;
+}
+
+SnapshotStats& HeapSnapshot::getStats() {
+    return stats;
+}
+
+std::vector<SnapshotAlgorithm>& HeapSnapshot::getAlgorithms() {
+    return algorithms;
+}
+
+std::vector<SnapshotBlock>& HeapSnapshot::getBlocks() {
+    return blocks;
+}
+
+void HeapSnapshot::setArenaCount(uint32_t arenaCount) {
+    this->arenaCount = arenaCount;
+}
+
+bool HeapSnapshot::write(const std::string& path) const {
+    size_t algorithmBytes = algorithms.size() * sizeof(SnapshotAlgorithm);
+    size_t blockBytes = blocks.size() * sizeof(SnapshotBlock);
+    
+    SnapshotHeader header = {};
+    std::memcpy(header.magic, MAGIC, sizeof(header.magic));
+    header.version = FORMAT_VERSION;
+    header.headerSize = sizeof(SnapshotHeader);
+    header.payloadSize = sizeof(SnapshotSettings) + sizeof(SnapshotStats) + algorithmBytes + blockBytes;
+    header.algorithmCount = static_cast<uint32_t>(algorithms.size());
+    header.arenaCount = arenaCount;
+    header.blockCount = blocks.size();
+    
+    uint64_t checksum = FNV_OFFSET_BASIS;
+    checksum = fnv1a(checksum, &settings, sizeof(settings));
+    checksum = fnv1a(checksum, &stats, sizeof(stats));
+    checksum = fnv1a(checksum, algorithms.data(), algorithmBytes);
+    checksum = fnv1a(checksum, blocks.data(), blockBytes);
+    header.checksum = checksum;
+    
+    // Each write gets its own temporary file, so concurrent saves to the same path never
+    // interleave; the last rename wins with a complete snapshot
+#if HEAP_SNAPSHOT_USE_MMAP
+    std::string tempPath = path + ".XXXXXX";
+    int fd = mkstemp(&tempPath[0]);
+    if (fd < 0) {
+        return false;
+    }
+    
+    // mkstemp creates the file owner-only; snapshots keep the permissions of a plain create
+    bool written = fchmod(fd, 0644) == 0 &&
+                   writeAll(fd, &header, sizeof(header)) &&
+                   writeAll(fd, &settings, sizeof(settings)) &&
+                   writeAll(fd, &stats, sizeof(stats)) &&
+                   writeAll(fd, algorithms.data(), algorithmBytes) &&
+                   writeAll(fd, blocks.data(), blockBytes) &&
+                   fsync(fd) == 0; // The data has to reach the disk before the rename does
+    ::close(fd);
+    
+    if (!written) {
+        std::remove(tempPath.c_str());
+        return false;
+    }
+#else
+    static std::atomic<uint64_t> tempCounter(0);
+    std::string tempPath = path + ".tmp" + std::to_string(tempCounter++);
+    {
+        std::ofstream out(tempPath, std::ios::binary | std::ios::trunc);
+        if (!out) {
+            return false;
+        }
+        
+        out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        out.write(reinterpret_cast<const char*>(&settings), sizeof(settings));
+        out.write(reinterpret_cast<const char*>(&stats), sizeof(stats));
+        out.write(reinterpret_cast<const char*>(algorithms.data()), algorithmBytes);
+        out.write(reinterpret_cast<const char*>(blocks.data()), blockBytes);
+        out.flush();
+        
+        if (!out) {
+            std::remove(tempPath.c_str());
+            return false;
+        }
+    }
+#endif
+    
+    if (std::rename(tempPath.c_str(), path.c_str()) != 0) {
+        std::remove(tempPath.c_str());
+        return false;
+    }
+    
+#if HEAP_SNAPSHOT_USE_MMAP
+    // Then the rename itself, which lives in the directory
+    size_t slash = path.find_last_of('/');
+    std::string directory = slash == std::string::npos ? "." : path.substr(0, std::max<size_t>(slash, 1));
+    syncPath(directory, O_RDONLY | O_DIRECTORY);
+#endif
+    
+    return true;
+}
+
+// MappedHeapSnapshot implementation
+MappedHeapSnapshot::MappedHeapSnapshot()
+    : data(nullptr), size(0) {}
+
+MappedHeapSnapshot::~MappedHeapSnapshot() {
+    close();
+}
+
+bool MappedHeapSnapshot::open(const std::string& path) {
+    close();
+    
+#if HEAP_SNAPSHOT_USE_MMAP
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+    
+    struct stat fileStat;
+    if (fstat(fd, &fileStat) != 0 || fileStat.st_size < static_cast<off_t>(sizeof(SnapshotHeader))) {
+        ::close(fd);
+        return false;
+    }
+    
+    void* mapping = mmap(nullptr, fileStat.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (mapping == MAP_FAILED) {
+        return false;
+    }
+    
+    // The restore walks the file front to back exactly once
+    madvise(mapping, fileStat.st_size, MADV_SEQUENTIAL);
+    data = static_cast<const unsigned char*>(mapping);
+    size = static_cast<size_t>(fileStat.st_size);
+#else
+    std::ifstream in(path, std::ios::binary | std::ios::ate);
+    if (!in) {
+        return false;
+    }
+    
+    fallbackBuffer.resize(static_cast<size_t>(in.tellg()));
+    in.seekg(0);
+    if (!in.read(reinterpret_cast<char*>(fallbackBuffer.data()), fallbackBuffer.size()) ||
+        fallbackBuffer.size() < sizeof(SnapshotHeader)) {
+        fallbackBuffer.clear();
+        return false;
+    }
+    
+    data = fallbackBuffer.data();
+    size = fallbackBuffer.size();
+#endif
+    
+    // Validate the header before trusting any of the counts in it
+    const SnapshotHeader& header = getHeader();
+    size_t payloadBytes = size - sizeof(SnapshotHeader);
+    bool valid = header.algorithmCount <= payloadBytes / sizeof(SnapshotAlgorithm) &&
+                 header.blockCount <= payloadBytes / sizeof(SnapshotBlock) &&
+                 std::memcmp(header.magic, HeapSnapshot::MAGIC, sizeof(header.magic)) == 0 &&
+                 header.version == HeapSnapshot::FORMAT_VERSION &&
+                 header.headerSize == sizeof(SnapshotHeader) &&
+                 header.payloadSize == sizeof(SnapshotSettings) + sizeof(SnapshotStats) +
+                                       header.algorithmCount * sizeof(SnapshotAlgorithm) +
+                                       header.blockCount * sizeof(SnapshotBlock) &&
+                 header.payloadSize == payloadBytes;
+    
+    if (valid) {
+        valid = fnv1a(FNV_OFFSET_BASIS, data + sizeof(SnapshotHeader), header.payloadSize) == header.checksum;
+    }
+    
+    if (!valid) {
+        close();
+        return false;
+    }
+    
+    return true;
+}
+
+void MappedHeapSnapshot::close() {
+#if HEAP_SNAPSHOT_USE_MMAP
+    if (data) {
+        munmap(const_cast<unsigned char*>(data), size);
+    }
+#endif
+    fallbackBuffer.clear();
+    data = nullptr;
+    size = 0;
+}
+
+const SnapshotHeader& MappedHeapSnapshot::getHeader() const {
+    return *reinterpret_cast<const SnapshotHeader*>(data);
+}
+
+const SnapshotSettings& MappedHeapSnapshot::getSettings() const {
+    return *reinterpret_cast<const SnapshotSettings*>(data + sizeof(SnapshotHeader));
+}
+
+const SnapshotStats& MappedHeapSnapshot::getStats() const {
+    return *reinterpret_cast<const SnapshotStats*>(data + sizeof(SnapshotHeader) + sizeof(SnapshotSettings));
+}
+
+const SnapshotAlgorithm* MappedHeapSnapshot::getAlgorithms() const {
+    return reinterpret_cast<const SnapshotAlgorithm*>(
+        data + sizeof(SnapshotHeader) + sizeof(SnapshotSettings) + sizeof(SnapshotStats));
+}
+
+const SnapshotBlock* MappedHeapSnapshot::getBlocks() const {
+    return reinterpret_cast<const SnapshotBlock*>(
+        reinterpret_cast<const unsigned char*>(getAlgorithms()) + getHeader().algorithmCount * sizeof(SnapshotAlgorithm));
+}
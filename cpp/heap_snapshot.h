@@ -0,0 +1,118 @@
+#ifndef HEAP_SNAPSHOT_H
+#define HEAP_SNAPSHOT_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Snapshot file layout (native byte order, meant for restarting on the same host):
+//   SnapshotHeader
+//   SnapshotSettings
+//   SnapshotStats
+//   SnapshotAlgorithm[algorithmCount]
+//   SnapshotBlock[blockCount]
+// Every record is fixed-size POD so the restore side can read it straight out of an mmap.
+
+struct SnapshotHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t headerSize;
+    uint64_t payloadSize;
+    uint64_t checksum; // FNV-1a over the payload
+    uint32_t algorithmCount;
+    uint32_t arenaCount;
+    uint64_t blockCount;
+};
+
+struct SnapshotSettings {
+    uint8_t autoCollection;
+    uint8_t backgroundCollection;
+    uint8_t collectionPriority;
+    uint8_t reserved;
+    int32_t memoryThreshold;
+    int32_t timeInterval;
+    int32_t cpuLimit;
+};
+
+struct SnapshotStats {
+    uint64_t totalMemory;
+    uint64_t memoryReclaimedTotal;
+    int64_t lastGcRun;
+    int32_t gcRunsToday;
+    int32_t averageGcDuration;
+    float cpuImpact;
+    int32_t nextBlockId;
+};
+
+struct SnapshotAlgorithm {
+    int32_t id;
+    int32_t performanceScore;
+    uint8_t enabled;
+    uint8_t reserved[7];
+};
+
+struct SnapshotBlock {
+    uint64_t size;
+    int32_t id;
+    int32_t arenaId;
+    uint8_t status;
+    uint8_t reserved[7];
+};
+
+// Heap Snapshot class
+// In-memory copy of the state to be persisted. Built quickly under the
+// relevant locks, then written out on a background thread.
+class HeapSnapshot {
+public:
+    static const char MAGIC[8];
+    static constexpr uint32_t FORMAT_VERSION = 1;
+    
+    HeapSnapshot();
+    
+    SnapshotSettings& getSettings();
+    SnapshotStats& getStats();
+    std::vector<SnapshotAlgorithm>& getAlgorithms();
+    std::vector<SnapshotBlock>& getBlocks();
+    void setArenaCount(uint32_t arenaCount);
+    
+    // Writes to a uniquely named temporary file next to path, syncs it and renames it over
+    // path, so readers never see a partial snapshot and a crash leaves either the old file
+    // or the complete new one; concurrent writes to one path each rename a whole file
+    bool write(const std::string& path) const;
+    
+private:
+    SnapshotSettings settings;
+    SnapshotStats stats;
+    std::vector<SnapshotAlgorithm> algorithms;
+    std::vector<SnapshotBlock> blocks;
+    uint32_t arenaCount;
+};
+
+// Mapped Heap Snapshot class
+// Read-only view of a snapshot file mapped into memory. Records are used in
+// place; nothing is copied until the caller rebuilds its own structures.
+class MappedHeapSnapshot {
+public:
+    MappedHeapSnapshot();
+    ~MappedHeapSnapshot();
+    
+    MappedHeapSnapshot(const MappedHeapSnapshot&) = delete;
+    MappedHeapSnapshot& operator=(const MappedHeapSnapshot&) = delete;
+    
+    // Maps the file and validates magic, version, sizes and checksum
+    bool open(const std::string& path);
+    void close();
+    
+    const SnapshotHeader& getHeader() const;
+    const SnapshotSettings& getSettings() const;
+    const SnapshotStats& getStats() const;
+    const SnapshotAlgorithm* getAlgorithms() const;
+    const SnapshotBlock* getBlocks() const;
+    
+private:
+    const unsigned char* data;
+    size_t size;
+    std::vector<unsigned char> fallbackBuffer; // Used where mmap is unavailable
+};
+
+#endif // HEAP_SNAPSHOT_H
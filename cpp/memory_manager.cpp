@@ -1,15 +1,29 @@
 #include "memory_manager.h"
+#include "metrics_exporter.h"
+#include "slab_allocator.h"
+#include "heap_snapshot.h"
+#include "heap_map.h"
+#include "gc_job_queue.h"
+#include "gc_kernels.h"
+#include "heap_backing.h"
+#include "allocation_profiler.h"
+#include "memory_pressure.h"
+#include "fleet_publisher.h"
+#include "reference_processor.h"
+#include "finalization_queue.h"
 #include <iostream>
 #include <algorithm>
 #include <random>
 #include <sstream>
 #include <iomanip>
 #include <ctime>
+#include <cstring>
 #include <json/json.h> // Requires JsonCpp library
 
 // MemoryBlock implementation
-MemoryBlock::MemoryBlock(int id, size_t size, BlockStatus status)
-    : id(id), size(size), status(status) {}
+MemoryBlock::MemoryBlock(int id, size_t size, BlockStatus status, int arenaId, size_t offset)
+    : id(id), size(size), state(static_cast<uint8_t>(status)), arenaId(arenaId), offset(offset), resident(false),
+      sample(AllocationProfiler::NOT_SAMPLED), referenceFlags(0) {}
 
 int MemoryBlock::getId() const {
     return id;
@@ -20,16 +34,116 @@ size_t MemoryBlock::getSize() const {
 }
 
 BlockStatus MemoryBlock::getStatus() const {
-    return status;
+    return static_cast<BlockStatus>(state.load() & STATUS_MASK);
+}
+
+int MemoryBlock::getArenaId() const {
+    return arenaId;
+}
+
+size_t MemoryBlock::getOffset() const {
+    return offset;
+}
+
+bool MemoryBlock::isPinned() const {
+    return (state.load() & PINNED) != 0;
+}
+
+bool MemoryBlock::isResident() const {
+    return resident;
+}
+
+bool MemoryBlock::isSampled() const {
+    return sample.load(std::memory_order_relaxed) != AllocationProfiler::NOT_SAMPLED;
+}
+
+uint8_t MemoryBlock::getReferenceFlags() const {
+    return referenceFlags.load(std::memory_order_relaxed);
 }
 
 void MemoryBlock::setStatus(BlockStatus status) {
-    this->status = status;
+    state = static_cast<uint8_t>(status);
+}
+
+void MemoryBlock::setSize(size_t size) {
+    this->size = size;
+}
+
+bool MemoryBlock::setPinned(bool pinned) {
+    uint8_t current = state.load();
+    while ((current & STATUS_MASK) == static_cast<uint8_t>(BlockStatus::ACTIVE)) {
+        uint8_t desired = pinned ? (current | PINNED) : (current & STATUS_MASK);
+        if (state.compare_exchange_weak(current, desired)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void MemoryBlock::setResident(bool resident) {
+    this->resident = resident;
+}
+
+void MemoryBlock::setOffset(size_t offset) {
+    this->offset = offset;
+}
+
+void MemoryBlock::setSample(uint32_t sample) {
+    this->sample.store(sample, std::memory_order_relaxed);
+}
+
+uint32_t MemoryBlock::takeSample() {
+    // Exactly one of a racing free and collection gets the sample
+    return sample.exchange(AllocationProfiler::NOT_SAMPLED, std::memory_order_relaxed);
+}
+
+void MemoryBlock::addReferenceFlags(uint8_t flags) {
+    referenceFlags.fetch_or(flags, std::memory_order_relaxed);
+}
+
+void MemoryBlock::clearReferenceFlags() {
+    referenceFlags.store(0, std::memory_order_relaxed);
+}
+
+bool MemoryBlock::compareAndSetStatus(BlockStatus expected, BlockStatus desired) {
+    uint8_t current = static_cast<uint8_t>(expected);
+    return state.compare_exchange_strong(current, static_cast<uint8_t>(desired));
+}
+
+bool MemoryBlock::claim(bool pin) {
+    uint8_t current = static_cast<uint8_t>(BlockStatus::FREE);
+    uint8_t desired = static_cast<uint8_t>(BlockStatus::ACTIVE) | (pin ? PINNED : 0);
+    return state.compare_exchange_strong(current, desired);
+}
+
+bool MemoryBlock::release() {
+    uint8_t current = state.load();
+    while ((current & STATUS_MASK) == static_cast<uint8_t>(BlockStatus::ACTIVE)) {
+        if (state.compare_exchange_weak(current, static_cast<uint8_t>(BlockStatus::FREE))) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// SweepRandom implementation
+SweepRandom::SweepRandom(uint64_t seed)
+    : state(seed != 0 ? seed : 0x9E3779B97F4A7C15ULL) {}
+
+uint64_t SweepRandom::next() {
+    state ^= state >> 12;
+    state ^= state << 25;
+    state ^= state >> 27;
+    return state * 0x2545F4914F6CDD1DULL;
 }
 
 // GcAlgorithm implementation
-GcAlgorithm::GcAlgorithm(int id, const std::string& name, const std::string& description, bool enabled, int performanceScore)
-    : id(id), name(name), description(description), enabled(enabled), performanceScore(performanceScore) {}
+GcAlgorithm::GcAlgorithm(int id, const std::string& name, const std::string& description, bool enabled, int performanceScore,
+                         const SweepKernels& kernels)
+    : id(id), name(name), description(description), enabled(enabled), performanceScore(performanceScore),
+      kernels(kernels), kernel(kernels[static_cast<size_t>(CollectionPriority::BALANCED)]),
+      sweepRandom((static_cast<uint64_t>(std::random_device{}()) << 32) | std::random_device{}()),
+      allocationProfiler(nullptr) {}
 
 int GcAlgorithm::getId() const {
     return id;
@@ -59,130 +173,780 @@ void GcAlgorithm::setPerformanceScore(int score) {
     this->performanceScore = score;
 }
 
+void GcAlgorithm::setCollectionPriority(CollectionPriority priority) {
+    kernel = kernels[static_cast<size_t>(priority)];
+}
+
+void GcAlgorithm::setAllocationProfiler(AllocationProfiler* profiler) {
+    allocationProfiler = profiler;
+}
+
+size_t GcAlgorithm::collect(std::vector<std::shared_ptr<MemoryBlock>>& blocks) {
+    return kernel(blocks, sweepRandom, allocationProfiler, discoveredBlocks);
+}
+
+size_t GcAlgorithm::collectArena(MemoryArena& arena) {
+    size_t memoryReclaimed = collect(arena.getBlocks());
+    arena.accountCollected(memoryReclaimed);
+    return memoryReclaimed;
+}
+
+std::vector<std::shared_ptr<MemoryBlock>>& GcAlgorithm::getDiscoveredBlocks() {
+    return discoveredBlocks;
+}
+
 // MarkSweepAlgorithm implementation
 MarkSweepAlgorithm::MarkSweepAlgorithm(int id)
-    : GcAlgorithm(id, "Mark-Sweep", "A basic GC algorithm that marks all reachable objects and then sweeps away the unmarked ones.", true, 72) {}
+    : GcAlgorithm(id, "Mark-Sweep", "A basic GC algorithm that marks all reachable objects and then sweeps away the unmarked ones.", true, 72,
+                  makeSweepKernels<MarkSweepPolicy>()) {}
 
-size_t MarkSweepAlgorithm::collect(std::vector<std::shared_ptr<MemoryBlock>>& blocks) {
-    size_t memoryReclaimed = 0;
+// GenerationalAlgorithm implementation
+GenerationalAlgorithm::GenerationalAlgorithm(int id)
+    : GcAlgorithm(id, "Generational", "Groups objects by age and collects younger generations more frequently than older ones.", true, 89,
+                  makeSweepKernels<GenerationalPolicy>()) {}
+
+// ReferenceCountingAlgorithm implementation
+ReferenceCountingAlgorithm::ReferenceCountingAlgorithm(int id)
+    : GcAlgorithm(id, "Reference Counting", "Keeps track of the number of references to each object and collects when count reaches zero.", true, 65,
+                  makeSweepKernels<ReferenceCountingPolicy>()) {}
+
+// ConcurrentGcAlgorithm implementation
+ConcurrentGcAlgorithm::ConcurrentGcAlgorithm(int id)
+    : GcAlgorithm(id, "Concurrent GC", "Performs collection alongside program execution to minimize pauses.", true, 78,
+                  makeSweepKernels<ConcurrentGcPolicy>()) {}
+
+// RegionEvacuationAlgorithm implementation
+RegionEvacuationAlgorithm::RegionEvacuationAlgorithm(int id, std::function<int()> nextBlockId,
+                                                     std::function<void(size_t, size_t, size_t)> moveMemory)
+    : GcAlgorithm(id, "Region Evacuation", "Evacuates live data out of the most garbage-rich regions within a pause target, compacting the heap as it collects.", false, 84,
+                  makeSweepKernels<RegionEvacuationPolicy>()),
+      nextBlockId(std::move(nextBlockId)), moveMemory(std::move(moveMemory)), pauseTargetMs(DEFAULT_PAUSE_TARGET_MS),
+      nanosPerBlock(50.0), lastRegionsEvacuated(0), lastPredictedPauseMs(0.0), lastEvacuationPauseMs(0.0) {}
+
+size_t RegionEvacuationAlgorithm::collectArena(MemoryArena& arena) {
+    // Marking: the sweep kernel decides which objects died since the last cycle
+    size_t memoryReclaimed = GcAlgorithm::collectArena(arena);
     
-    // Mark phase - in a real implementation, this would traverse the object graph
-    // For simulation, we'll just randomly mark some blocks as free
-    std::random_device rd;
-    std::mt19937 gen(rd());
-    std::uniform_real_distribution<> dis(0.0, 1.0);
+    // Regions are address ranges, so the table is walked in address order
+    auto& blocks = arena.getBlocks();
+    std::sort(blocks.begin(), blocks.end(),
+              [](const std::shared_ptr<MemoryBlock>& a, const std::shared_ptr<MemoryBlock>& b) {
+                  return a->getOffset() < b->getOffset();
+              });
+    std::vector<Region> regions = buildRegions(blocks);
     
-    for (auto& block : blocks) {
-        if (block->getStatus() == BlockStatus::ACTIVE && dis(gen) < 0.3) {
-            memoryReclaimed += block->getSize();
-            block->setStatus(BlockStatus::FREE);
+    // Wholly free regions are the to-space live data is copied into
+    std::vector<size_t> freeRegions;
+    size_t toSpaceBytes = 0;
+    std::vector<size_t> order;
+    for (size_t i = 0; i < regions.size(); ++i) {
+        if (regions[i].free) {
+            freeRegions.push_back(i);
+            toSpaceBytes += regions[i].bytes;
+        } else if (!regions[i].pinned && regions[i].garbageRatio >= MIN_GARBAGE_RATIO) {
+            order.push_back(i);
         }
     }
     
+    // Most garbage first, like a collection set; stop once the predicted pause hits the target.
+    // A region is only taken if its live data fits the to-space left, which each evacuated
+    // region grows by the space it frees.
+    std::stable_sort(order.begin(), order.end(), [&regions](size_t a, size_t b) {
+        return regions[a].garbageRatio > regions[b].garbageRatio;
+    });
+    
+    const double pauseBudgetMs = static_cast<double>(pauseTargetMs.load());
+    double predictedPauseMs = 0.0;
+    std::vector<size_t> collectionSet;
+    for (size_t index : order) {
+        const Region& region = regions[index];
+        double regionCostMs = static_cast<double>(region.last - region.first) * nanosPerBlock / 1e6;
+        if (predictedPauseMs + regionCostMs > pauseBudgetMs) {
+            break;
+        }
+        if (region.liveBytes > toSpaceBytes) {
+            continue;
+        }
+        predictedPauseMs += regionCostMs;
+        toSpaceBytes += region.bytes - region.liveBytes;
+        collectionSet.push_back(index);
+    }
+    
+    lastRegionsEvacuated = collectionSet.size();
+    lastPredictedPauseMs = predictedPauseMs;
+    if (collectionSet.empty()) {
+        lastEvacuationPauseMs = 0.0;
+        return memoryReclaimed;
+    }
+    
+    // Evacuation: live blocks are copied into to-space and take new offsets, and the
+    // region they leave becomes to-space in turn. Whatever to-space is left over at the
+    // end goes back into the table as one free block per address run.
+    auto startTime = std::chrono::steady_clock::now();
+    
+    struct Extent {
+        size_t offset;
+        size_t size;
+        bool resident;
+    };
+    std::vector<Extent> toSpace;
+    std::vector<bool> dropped(blocks.size(), false);
+    size_t blocksVisited = 0;
+    size_t nextFreeRegion = 0;
+    
+    auto addExtent = [&toSpace](size_t offset, size_t size, bool resident) {
+        if (!toSpace.empty() && toSpace.back().offset + toSpace.back().size == offset) {
+            toSpace.back().size += size;
+            toSpace.back().resident = toSpace.back().resident || resident;
+        } else {
+            toSpace.push_back(Extent{offset, size, resident});
+        }
+    };
+    
+    // Free blocks leave the table; a block a mutator claims first stays where it is
+    auto retireBlock = [&](size_t index) {
+        const auto& block = blocks[index];
+        if (block->getStatus() == BlockStatus::FRAGMENTED) {
+            arena.reclaimFragmentedBlock(block); // Fragmented space is garbage too
+        }
+        if (block->getStatus() != BlockStatus::FREE || !arena.retireFreeBlock(block)) {
+            return false;
+        }
+        dropped[index] = true;
+        return true;
+    };
+    
+    // Free regions are only turned into to-space once the space is needed
+    auto takeFreeRegion = [&]() {
+        while (nextFreeRegion < freeRegions.size()) {
+            const Region& region = regions[freeRegions[nextFreeRegion++]];
+            bool taken = false;
+            for (size_t j = region.first; j < region.last; ++j) {
+                if (retireBlock(j)) {
+                    addExtent(blocks[j]->getOffset(), blocks[j]->getSize(), blocks[j]->isResident());
+                    taken = true;
+                }
+            }
+            blocksVisited += region.last - region.first;
+            if (taken) {
+                return true;
+            }
+        }
+        return false;
+    };
+    
+    // First fit in to-space, so live data packs towards the low end of each extent
+    auto relocate = [&](const std::shared_ptr<MemoryBlock>& block) {
+        size_t size = block->getSize();
+        while (true) {
+            for (Extent& extent : toSpace) {
+                if (extent.size < size) {
+                    continue;
+                }
+                if (block->isResident()) {
+                    moveMemory(block->getOffset(), extent.offset, size);
+                }
+                block->setOffset(extent.offset);
+                extent.offset += size;
+                extent.size -= size;
+                return true;
+            }
+            if (!takeFreeRegion()) {
+                return false;
+            }
+        }
+    };
+    
+    for (size_t index : collectionSet) {
+        const Region& region = regions[index];
+        
+        // The region's own space only becomes to-space once all of it has been walked
+        std::vector<Extent> vacated;
+        for (size_t j = region.first; j < region.last; ++j) {
+            const auto& block = blocks[j];
+            size_t offset = block->getOffset();
+            size_t size = block->getSize();
+            bool resident = block->isResident();
+            bool freed = retireBlock(j);
+            
+            // Pinned blocks belong to a mutator and blocks with reference state are about to be
+            // processed; both stay, and so does a block that does not fit anywhere
+            if (freed || (block->getStatus() == BlockStatus::ACTIVE && !block->isPinned() &&
+                          block->getReferenceFlags() == 0 && relocate(block))) {
+                if (!vacated.empty() && vacated.back().offset + vacated.back().size == offset) {
+                    vacated.back().size += size;
+                    vacated.back().resident = vacated.back().resident || resident;
+                } else {
+                    vacated.push_back(Extent{offset, size, resident});
+                }
+            }
+        }
+        for (const Extent& extent : vacated) {
+            addExtent(extent.offset, extent.size, extent.resident);
+        }
+        blocksVisited += region.last - region.first;
+    }
+    
+    std::vector<std::shared_ptr<MemoryBlock>> newBlocks;
+    newBlocks.reserve(blocks.size() + toSpace.size());
+    for (size_t i = 0; i < blocks.size(); ++i) {
+        if (!dropped[i]) {
+            newBlocks.push_back(blocks[i]);
+        }
+    }
+    
+    // Extents were added out of address order; merge the ones that touch before handing them back.
+    // Relocated blocks took exactly the space they vacated, so the runs add up to the retired bytes
+    // and the arena's totals come out unchanged.
+    std::sort(toSpace.begin(), toSpace.end(), [](const Extent& a, const Extent& b) { return a.offset < b.offset; });
+    size_t addedFreeBytes = 0;
+    size_t runOffset = 0;
+    size_t runBytes = 0;
+    bool runResident = false;
+    auto flushRun = [&]() {
+        if (runBytes == 0) {
+            return;
+        }
+        auto freeBlock = std::make_shared<MemoryBlock>(nextBlockId(), runBytes, BlockStatus::FREE, arena.getId(), runOffset);
+        freeBlock->setResident(runResident);
+        newBlocks.push_back(freeBlock);
+        addedFreeBytes += runBytes;
+        runBytes = 0;
+        runResident = false;
+    };
+    for (const Extent& extent : toSpace) {
+        if (extent.size == 0) {
+            continue;
+        }
+        if (extent.offset != runOffset + runBytes) {
+            flushRun();
+            runOffset = extent.offset;
+        }
+        runBytes += extent.size;
+        runResident = runResident || extent.resident;
+    }
+    flushRun();
+    
+    std::sort(newBlocks.begin(), newBlocks.end(),
+              [](const std::shared_ptr<MemoryBlock>& a, const std::shared_ptr<MemoryBlock>& b) {
+                  return a->getOffset() < b->getOffset();
+              });
+    arena.replaceBlocks(std::move(newBlocks), addedFreeBytes);
+    
+    auto pause = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startTime);
+    lastEvacuationPauseMs = pause.count();
+    
+    // Fold the measured cost into the next prediction
+    if (blocksVisited > 0) {
+        double observedNanosPerBlock = pause.count() * 1e6 / static_cast<double>(blocksVisited);
+        nanosPerBlock = nanosPerBlock * 0.7 + observedNanosPerBlock * 0.3;
+    }
+    
     return memoryReclaimed;
 }
 
-// GenerationalAlgorithm implementation
-GenerationalAlgorithm::GenerationalAlgorithm(int id)
-    : GcAlgorithm(id, "Generational", "Groups objects by age and collects younger generations more frequently than older ones.", true, 89) {}
+std::vector<RegionEvacuationAlgorithm::Region> RegionEvacuationAlgorithm::buildRegions(
+    const std::vector<std::shared_ptr<MemoryBlock>>& blocks) const {
+    std::vector<Region> regions;
+    if (blocks.empty()) {
+        return regions;
+    }
+    
+    // Blocks are in address order; each belongs to the REGION_SIZE-aligned range its start falls in
+    size_t base = blocks.front()->getOffset();
+    Region current{0, 0, 0, 0, 0.0, true, false};
+    size_t currentIndex = 0;
+    for (size_t i = 0; i < blocks.size(); ++i) {
+        const auto& block = blocks[i];
+        size_t regionIndex = (block->getOffset() - base) / REGION_SIZE;
+        if (regionIndex != currentIndex && current.last > current.first) {
+            regions.push_back(current);
+            current = Region{i, i, 0, 0, 0.0, true, false};
+        }
+        currentIndex = regionIndex;
+        
+        current.bytes += block->getSize();
+        if (block->getStatus() == BlockStatus::ACTIVE) {
+            current.liveBytes += block->getSize();
+            current.pinned = current.pinned || block->isPinned() || block->getReferenceFlags() != 0;
+        }
+        current.free = current.free && block->getStatus() == BlockStatus::FREE;
+        current.last = i + 1;
+    }
+    regions.push_back(current);
+    
+    for (Region& region : regions) {
+        region.garbageRatio = region.bytes > 0
+            ? 1.0 - static_cast<double>(region.liveBytes) / static_cast<double>(region.bytes)
+            : 0.0;
+    }
+    return regions;
+}
 
-size_t GenerationalAlgorithm::collect(std::vector<std::shared_ptr<MemoryBlock>>& blocks) {
-    size_t memoryReclaimed = 0;
+int RegionEvacuationAlgorithm::getPauseTargetMs() const {
+    return pauseTargetMs;
+}
+
+void RegionEvacuationAlgorithm::setPauseTargetMs(int pauseTargetMs) {
+    this->pauseTargetMs = std::max(1, pauseTargetMs);
+}
+
+size_t RegionEvacuationAlgorithm::getLastRegionsEvacuated() const {
+    return lastRegionsEvacuated;
+}
+
+double RegionEvacuationAlgorithm::getLastPredictedPauseMs() const {
+    return lastPredictedPauseMs;
+}
+
+double RegionEvacuationAlgorithm::getLastEvacuationPauseMs() const {
+    return lastEvacuationPauseMs;
+}
+
+// GcActivity implementation
+GcActivity::GcActivity(int id, int algorithmId, const std::chrono::system_clock::time_point& timestamp,
+                      int durationMs, size_t memoryReclaimed, int objectsCollected, float cpuImpact,
+                      std::chrono::microseconds pauseTime, std::chrono::microseconds referenceProcessingTime)
+    : id(id), algorithmId(algorithmId), timestamp(timestamp), durationMs(durationMs),
+      memoryReclaimed(memoryReclaimed), objectsCollected(objectsCollected), cpuImpact(cpuImpact),
+      pauseTime(pauseTime), referenceProcessingTime(referenceProcessingTime) {}
+
+int GcActivity::getId() const {
+    return id;
+}
+
+int GcActivity::getAlgorithmId() const {
+    return algorithmId;
+}
+
+std::chrono::system_clock::time_point GcActivity::getTimestamp() const {
+    return timestamp;
+}
+
+int GcActivity::getDurationMs() const {
+    return durationMs;
+}
+
+size_t GcActivity::getMemoryReclaimed() const {
+    return memoryReclaimed;
+}
+
+int GcActivity::getObjectsCollected() const {
+    return objectsCollected;
+}
+
+float GcActivity::getCpuImpact() const {
+    return cpuImpact;
+}
+
+std::chrono::microseconds GcActivity::getPauseTime() const {
+    return pauseTime;
+}
+
+std::chrono::microseconds GcActivity::getReferenceProcessingTime() const {
+    return referenceProcessingTime;
+}
+
+// PauseHistogram implementation
+const std::array<double, PauseHistogram::BUCKET_COUNT> PauseHistogram::BUCKET_BOUNDS_SECONDS = {
+    0.0005, 0.001, 0.0025, 0.005, 0.01, 0.025, 0.05, 0.1, 0.25, 0.5, 1.0, 2.5
+};
+
+PauseHistogram::PauseHistogram()
+    : count(0), sumMicros(0) {
+    for (auto& bucket : buckets) {
+        bucket.store(0, std::memory_order_relaxed);
+    }
+}
+
+void PauseHistogram::record(std::chrono::microseconds pause) {
+    double seconds = pause.count() / 1000000.0;
     
-    // In a real implementation, this would focus on younger generations
-    // For simulation, we'll just randomly mark some blocks as free
-    std::random_device rd;
-    std::mt19937 gen(rd());
-    std::uniform_real_distribution<> dis(0.0, 1.0);
+    // Observations above the last bound only show up in the +Inf bucket (the total count)
+    for (size_t i = 0; i < BUCKET_COUNT; ++i) {
+        if (seconds <= BUCKET_BOUNDS_SECONDS[i]) {
+            buckets[i].fetch_add(1, std::memory_order_relaxed);
+            break;
+        }
+    }
+    
+    sumMicros.fetch_add(static_cast<uint64_t>(pause.count()), std::memory_order_relaxed);
+    count.fetch_add(1, std::memory_order_relaxed);
+}
+
+uint64_t PauseHistogram::getCumulativeCount(size_t index) const {
+    uint64_t cumulative = 0;
+    for (size_t i = 0; i <= index && i < BUCKET_COUNT; ++i) {
+        cumulative += buckets[i].load(std::memory_order_relaxed);
+    }
+    return cumulative;
+}
+
+uint64_t PauseHistogram::getCount() const {
+    return count.load(std::memory_order_relaxed);
+}
+
+double PauseHistogram::getSumSeconds() const {
+    return sumMicros.load(std::memory_order_relaxed) / 1000000.0;
+}
+
+// MemoryArena implementation
+MemoryArena::MemoryArena(int id)
+    : id(id), materialized(true), regionOffset(0), regionSize(0), regionSeed(0),
+      totalMemory(0), usedMemory(0), freeMemory(0), fragmentedMemory(0) {}
+
+int MemoryArena::getId() const {
+    return id;
+}
+
+size_t MemoryArena::getTotalMemory() const {
+    return totalMemory;
+}
+
+size_t MemoryArena::getUsedMemory() const {
+    return usedMemory;
+}
+
+size_t MemoryArena::getFreeMemory() const {
+    return freeMemory;
+}
+
+size_t MemoryArena::getFragmentedMemory() const {
+    return fragmentedMemory;
+}
+
+bool MemoryArena::isMaterialized() const {
+    return materialized.load(std::memory_order_acquire);
+}
+
+size_t MemoryArena::getRegionOffset() const {
+    return regionOffset;
+}
+
+size_t MemoryArena::getRegionSize() const {
+    return regionSize;
+}
+
+uint32_t MemoryArena::getRegionSeed() const {
+    return regionSeed;
+}
+
+void MemoryArena::setPendingRegion(size_t regionOffset, size_t regionSize, uint32_t regionSeed) {
+    this->regionOffset = regionOffset;
+    this->regionSize = regionSize;
+    this->regionSeed = regionSeed;
+    materialized.store(false, std::memory_order_release);
+}
+
+void MemoryArena::markMaterialized() {
+    materialized.store(true, std::memory_order_release);
+}
+
+std::mutex& MemoryArena::getMutex() const {
+    return mutex;
+}
+
+std::vector<std::shared_ptr<MemoryBlock>>& MemoryArena::getBlocks() {
+    return blocks;
+}
+
+const std::vector<std::shared_ptr<MemoryBlock>>& MemoryArena::getBlocks() const {
+    return blocks;
+}
+
+void MemoryArena::reserveBlocks(size_t count) {
+    blocks.reserve(blocks.size() + count);
+    freeList.reserve(freeList.size() + count);
+}
+
+void MemoryArena::addBlock(const std::shared_ptr<MemoryBlock>& block) {
+    blocks.push_back(block);
+    totalMemory += block->getSize();
+    
+    // Fragmented blocks count as used until optimization hands them back
+    switch (block->getStatus()) {
+        case BlockStatus::FREE:
+            freeMemory += block->getSize();
+            freeList.push_back(block);
+            break;
+        case BlockStatus::FRAGMENTED:
+            fragmentedMemory += block->getSize();
+            usedMemory += block->getSize();
+            break;
+        case BlockStatus::ACTIVE:
+            usedMemory += block->getSize();
+            break;
+    }
+}
+
+std::shared_ptr<MemoryBlock> MemoryArena::takeFreeBlock(size_t minSize) {
+    // Search from the back so the common case pops without shifting the vector
+    for (size_t i = freeList.size(); i-- > 0;) {
+        if (freeList[i]->getStatus() != BlockStatus::FREE) {
+            // Stale entry, drop it
+            freeList[i] = std::move(freeList.back());
+            freeList.pop_back();
+            continue;
+        }
+        
+        if (freeList[i]->getSize() >= minSize) {
+            std::shared_ptr<MemoryBlock> block = std::move(freeList[i]);
+            freeList[i] = std::move(freeList.back());
+            freeList.pop_back();
+            return block;
+        }
+    }
     
-    for (auto& block : blocks) {
-        if (block->getStatus() == BlockStatus::ACTIVE && dis(gen) < 0.4) {
-            memoryReclaimed += block->getSize();
-            block->setStatus(BlockStatus::FREE);
+    return nullptr;
+}
+
+void MemoryArena::pushFreeBlock(const std::shared_ptr<MemoryBlock>& block) {
+    freeList.push_back(block);
+}
+
+void MemoryArena::rebuildFreeList() {
+    // Blocks sitting in thread caches may be listed again; claimBlock() resolves the duplicates
+    freeList.clear();
+    for (const auto& block : blocks) {
+        if (block->getStatus() == BlockStatus::FREE) {
+            freeList.push_back(block);
         }
     }
+}
+
+std::shared_ptr<MemoryBlock> MemoryArena::splitBlock(const std::shared_ptr<MemoryBlock>& block, size_t keepSize,
+                                                    int tailId) {
+    size_t tailSize = block->getSize() - keepSize;
+    auto tail = std::make_shared<MemoryBlock>(tailId, tailSize, BlockStatus::FREE, id, block->getOffset() + keepSize);
+    tail->setResident(block->isResident());
     
-    return memoryReclaimed;
+    block->setSize(keepSize);
+    blocks.push_back(tail);
+    freeList.push_back(tail);
+    
+    usedMemory -= tailSize;
+    freeMemory += tailSize;
+    return tail;
 }
 
-// ReferenceCountingAlgorithm implementation
-ReferenceCountingAlgorithm::ReferenceCountingAlgorithm(int id)
-    : GcAlgorithm(id, "Reference Counting", "Keeps track of the number of references to each object and collects when count reaches zero.", true, 65) {}
+void MemoryArena::clear() {
+    // Retire the blocks first: handles held elsewhere can then no longer claim or release them
+    for (const auto& block : blocks) {
+        block->setStatus(BlockStatus::FRAGMENTED);
+    }
+    blocks.clear();
+    freeList.clear();
+    totalMemory = 0;
+    usedMemory = 0;
+    freeMemory = 0;
+    fragmentedMemory = 0;
+    markMaterialized();
+}
+
+bool MemoryArena::claimBlock(const std::shared_ptr<MemoryBlock>& block, bool pin) {
+    // Count the bytes as used before publishing the block as active, so a collector
+    // that frees it straight away can never drive the counter below zero
+    usedMemory += block->getSize();
+    
+    if (!block->claim(pin)) {
+        usedMemory -= block->getSize();
+        return false;
+    }
+    
+    freeMemory -= block->getSize();
+    block->setResident(true);
+    return true;
+}
+
+bool MemoryArena::releaseBlock(const std::shared_ptr<MemoryBlock>& block) {
+    if (!block->release()) {
+        return false;
+    }
+    
+    freeMemory += block->getSize();
+    usedMemory -= block->getSize();
+    return true;
+}
+
+bool MemoryArena::reclaimFragmentedBlock(const std::shared_ptr<MemoryBlock>& block) {
+    if (!block->compareAndSetStatus(BlockStatus::FRAGMENTED, BlockStatus::FREE)) {
+        return false;
+    }
+    
+    freeMemory += block->getSize();
+    fragmentedMemory -= block->getSize();
+    usedMemory -= block->getSize();
+    return true;
+}
+
+void MemoryArena::accountCollected(size_t memoryReclaimed) {
+    freeMemory += memoryReclaimed;
+    usedMemory -= memoryReclaimed;
+}
+
+bool MemoryArena::retireFreeBlock(const std::shared_ptr<MemoryBlock>& block) {
+    // Retired blocks read as fragmented, which no mutator path touches: stale free-list
+    // and cache entries fail to claim them and late frees fail to release them
+    if (!block->compareAndSetStatus(BlockStatus::FREE, BlockStatus::FRAGMENTED)) {
+        return false;
+    }
+    
+    freeMemory -= block->getSize();
+    totalMemory -= block->getSize();
+    return true;
+}
+
+void MemoryArena::replaceBlocks(std::vector<std::shared_ptr<MemoryBlock>> newBlocks, size_t addedFreeBytes) {
+    blocks = std::move(newBlocks);
+    totalMemory += addedFreeBytes;
+    freeMemory += addedFreeBytes;
+}
+
+// ThreadLocalAllocationBuffer implementation
+ThreadLocalAllocationBuffer::ThreadLocalAllocationBuffer()
+    : chunkId(0), top(0), limit(0), end(0), countedTop(0), sampleDistance(0), desiredSize(MIN_SIZE), allocationRate(0.0) {}
+
+bool ThreadLocalAllocationBuffer::tryAllocate(size_t size, ObjectAllocation& allocation) {
+    if (size > limit - top) {
+        return false;
+    }
+    
+    allocation.blockId = chunkId;
+    allocation.sample = AllocationProfiler::NOT_SAMPLED;
+    allocation.offset = top;
+    allocation.size = size;
+    top += size;
+    return true;
+}
+
+void ThreadLocalAllocationBuffer::reset(const std::shared_ptr<MemoryBlock>& chunk,
+                                        std::chrono::steady_clock::time_point now) {
+    this->chunk = chunk;
+    chunkId = chunk->getId();
+    top = 0;
+    end = chunk->getSize();
+    limit = end;
+    countedTop = 0;
+    startTime = now;
+}
+
+void ThreadLocalAllocationBuffer::clear() {
+    chunk.reset();
+    chunkId = 0;
+    top = 0;
+    limit = 0;
+    end = 0;
+    countedTop = 0;
+    sampledObjects.clear();
+}
+
+void ThreadLocalAllocationBuffer::updateDesiredSize(std::chrono::steady_clock::time_point now) {
+    double lifetimeSeconds = std::chrono::duration<double>(now - startTime).count();
+    if (lifetimeSeconds <= 0.0) {
+        // Filled faster than the clock ticks, so grow as fast as allowed
+        desiredSize = std::min(desiredSize * 2, MAX_SIZE);
+        return;
+    }
+    
+    double rate = top / lifetimeSeconds;
+    allocationRate = allocationRate == 0.0 ? rate : 0.7 * allocationRate + 0.3 * rate;
+    
+    double target = allocationRate * std::chrono::duration<double>(REFILL_INTERVAL).count();
+    size_t aligned = (static_cast<size_t>(target) + ALIGNMENT - 1) & ~(ALIGNMENT - 1);
+    desiredSize = std::max(MIN_SIZE, std::min(aligned, MAX_SIZE));
+}
+
+std::shared_ptr<MemoryBlock> ThreadLocalAllocationBuffer::getChunk() const {
+    return chunk;
+}
+
+size_t ThreadLocalAllocationBuffer::getUsed() const {
+    return top;
+}
+
+size_t ThreadLocalAllocationBuffer::getRemaining() const {
+    return end - top;
+}
+
+size_t ThreadLocalAllocationBuffer::getDesiredSize() const {
+    return desiredSize;
+}
+
+int64_t ThreadLocalAllocationBuffer::getSampleDistance() const {
+    return sampleDistance;
+}
+
+void ThreadLocalAllocationBuffer::setSampleDistance(int64_t distance) {
+    sampleDistance = distance;
+    countedTop = top;
+    size_t remaining = static_cast<size_t>(std::max<int64_t>(0, distance));
+    limit = remaining < end - top ? top + remaining : end;
+}
+
+bool ThreadLocalAllocationBuffer::consumeSampleBytes(size_t size) {
+    sampleDistance -= static_cast<int64_t>(top - countedTop + size);
+    countedTop = top;
+    limit = end;
+    return sampleDistance < 0;
+}
+
+void ThreadLocalAllocationBuffer::addSampledObject(const ObjectAllocation& allocation) {
+    sampledObjects.push_back(allocation);
+}
 
-size_t ReferenceCountingAlgorithm::collect(std::vector<std::shared_ptr<MemoryBlock>>& blocks) {
-    size_t memoryReclaimed = 0;
-    
-    // In a real implementation, this would check reference counts
-    // For simulation, we'll just randomly mark some blocks as free
-    std::random_device rd;
-    std::mt19937 gen(rd());
-    std::uniform_real_distribution<> dis(0.0, 1.0);
-    
-    for (auto& block : blocks) {
-        if (block->getStatus() == BlockStatus::ACTIVE && dis(gen) < 0.25) {
-            memoryReclaimed += block->getSize();
-            block->setStatus(BlockStatus::FREE);
-        }
-    }
-    
-    return memoryReclaimed;
+const std::vector<ObjectAllocation>& ThreadLocalAllocationBuffer::getSampledObjects() const {
+    return sampledObjects;
 }
 
-// ConcurrentGcAlgorithm implementation
-ConcurrentGcAlgorithm::ConcurrentGcAlgorithm(int id)
-    : GcAlgorithm(id, "Concurrent GC", "Performs collection alongside program execution to minimize pauses.", true, 78) {}
+// ThreadAllocationCache implementation
+ThreadAllocationCache::ThreadAllocationCache(size_t arenaIndex)
+    : owned(false), epoch(0), arenaIndex(arenaIndex), bytesUntilSample(0),
+      sampleRandom((static_cast<uint64_t>(std::random_device{}()) << 32) | std::random_device{}()) {
+    blocks.reserve(CAPACITY);
+}
 
-size_t ConcurrentGcAlgorithm::collect(std::vector<std::shared_ptr<MemoryBlock>>& blocks) {
-    size_t memoryReclaimed = 0;
-    
-    // In a real implementation, this would run concurrently with the application
-    // For simulation, we'll just randomly mark some blocks as free
-    std::random_device rd;
-    std::mt19937 gen(rd());
-    std::uniform_real_distribution<> dis(0.0, 1.0);
-    
-    for (auto& block : blocks) {
-        if (block->getStatus() == BlockStatus::ACTIVE && dis(gen) < 0.35) {
-            memoryReclaimed += block->getSize();
-            block->setStatus(BlockStatus::FREE);
-        }
-    }
-    
-    return memoryReclaimed;
+bool ThreadAllocationCache::tryAcquire() {
+    // Acquire pairs with release(), so the new owner sees everything the last one wrote
+    return !owned.exchange(true, std::memory_order_acquire);
 }
 
-// GcActivity implementation
-GcActivity::GcActivity(int id, int algorithmId, const std::chrono::system_clock::time_point& timestamp,
-                      int durationMs, size_t memoryReclaimed, int objectsCollected, float cpuImpact)
-    : id(id), algorithmId(algorithmId), timestamp(timestamp), durationMs(durationMs),
-      memoryReclaimed(memoryReclaimed), objectsCollected(objectsCollected), cpuImpact(cpuImpact) {}
+void ThreadAllocationCache::release() {
+    owned.store(false, std::memory_order_release);
+}
 
-int GcActivity::getId() const {
-    return id;
+uint64_t ThreadAllocationCache::getEpoch() const {
+    return epoch;
 }
 
-int GcActivity::getAlgorithmId() const {
-    return algorithmId;
+void ThreadAllocationCache::invalidate(uint64_t epoch) {
+    blocks.clear();
+    tlab.clear();
+    this->epoch = epoch;
 }
 
-std::chrono::system_clock::time_point GcActivity::getTimestamp() const {
-    return timestamp;
+size_t ThreadAllocationCache::getArenaIndex() const {
+    return arenaIndex;
 }
 
-int GcActivity::getDurationMs() const {
-    return durationMs;
+std::vector<std::shared_ptr<MemoryBlock>>& ThreadAllocationCache::getBlocks() {
+    return blocks;
 }
 
-size_t GcActivity::getMemoryReclaimed() const {
-    return memoryReclaimed;
+ThreadLocalAllocationBuffer& ThreadAllocationCache::getTlab() {
+    return tlab;
 }
 
-int GcActivity::getObjectsCollected() const {
-    return objectsCollected;
+bool ThreadAllocationCache::consumeSampleBytes(size_t size) {
+    bytesUntilSample -= static_cast<int64_t>(size);
+    return bytesUntilSample < 0;
 }
 
-float GcActivity::getCpuImpact() const {
-    return cpuImpact;
+void ThreadAllocationCache::setBytesUntilSample(int64_t bytes) {
+    bytesUntilSample = bytes;
+}
+
+SweepRandom& ThreadAllocationCache::getSampleRandom() {
+    return sampleRandom;
 }
 
 // MemoryRecord implementation
@@ -270,12 +1034,69 @@ void GcSettings::setCollectionPriority(CollectionPriority collectionPriority) {
 }
 
 // MemoryManager implementation
-MemoryManager::MemoryManager()
-    : totalMemory(0), usedMemory(0), freeMemory(0), fragmentation(0.0f),
-      gcRunsToday(0), averageGcDuration(0), cpuImpact(0.0f), running(false), wsServer(nullptr) {
+namespace {
+
+std::atomic<uint64_t> nextManagerInstanceId(1);
+
+// Each thread remembers the cache it last used; the instance id guards against
+// following the pointer into a different (or destroyed) manager. The slot shares
+// ownership of the cache, and gives it up when it rebinds or its thread exits.
+struct ThreadCacheSlot {
+    uint64_t managerInstanceId = 0;
+    std::shared_ptr<ThreadAllocationCache> cache;
+    
+    void bind(uint64_t instanceId, std::shared_ptr<ThreadAllocationCache> newCache) {
+        if (cache) {
+            cache->release();
+        }
+        managerInstanceId = instanceId;
+        cache = std::move(newCache);
+    }
+    
+    ~ThreadCacheSlot() {
+        if (cache) {
+            cache->release();
+        }
+    }
+};
+
+thread_local ThreadCacheSlot threadCacheSlot;
+
+} // namespace
+
+MemoryManager::MemoryManager(size_t arenaCount, size_t heapSize, bool lazyInitialization, bool realMemory)
+    : nextActivityId(1), totalMemory(0), heapCapacity(heapSize), gcRunsToday(0), lastGcRun(0), averageGcDuration(0), cpuImpact(0.0f),
+      memoryReclaimedTotal(0), running(false), pressureMonitoring(false),
+      pressureLevel(MemoryPressureLevel::NONE), instanceId(nextManagerInstanceId++), cacheEpoch(0),
+      nextArenaAssignment(0), nextBlockId(1), tlabRefills(0), tlabAllocatedBytes(0), tlabRetiredBytes(0),
+      tlabWasteBytes(0), releasedMemoryTotal(0), heapMapVersions(0), wsServer(nullptr) {
+    
+    // Create arenas
+    if (arenaCount == 0) {
+        arenaCount = std::max(1u, std::thread::hardware_concurrency());
+    }
+    for (size_t i = 0; i < arenaCount; ++i) {
+        arenas.push_back(std::make_unique<MemoryArena>(static_cast<int>(i)));
+    }
+    
+    // Small objects get their slabs from the block heap
+    slabAllocator = createSlabAllocator();
+    
+    allocationProfiler = std::make_unique<AllocationProfiler>();
+    
+    // Reserve address space up front; blocks map into it by offset
+    if (realMemory) {
+        backing = std::make_unique<HeapBacking>();
+        if (!backing->reserve(heapSize)) {
+            std::cerr << "Could not reserve " << heapSize << " bytes; falling back to a simulated heap" << std::endl;
+            backing.reset();
+        } else {
+            heapResidency = std::make_unique<HeapResidency>(backing->readResidency());
+        }
+    }
     
     // Initialize memory
-    initializeMemory();
+    initializeMemory(heapSize, lazyInitialization);
     
     // Initialize algorithms
     initializeAlgorithms();
@@ -283,14 +1104,41 @@ MemoryManager::MemoryManager()
     // Initialize settings
     settings = std::make_shared<GcSettings>(true, 75, 30, true, 20, CollectionPriority::BALANCED);
     
+    // Control commands are queued for a worker pool and answered with job events
+    gcJobs = std::make_unique<GcJobQueue>(
+        [this](GcJobType type, const GcProgressCallback& progress) { return runGcJob(type, progress); },
+        [this](const GcJobEvent& event) { sendGcJobEvent(event); });
+    
+    // Finalizers run on their own thread and hand their blocks back once done
+    referenceProcessor = std::make_unique<ReferenceProcessor>();
+    finalizationQueue = std::make_unique<FinalizationQueue>(
+        [this](const std::shared_ptr<MemoryBlock>& block) { releaseFinalizedBlock(block); });
+    
+    // Watch the machine's memory pressure, then start the scheduler it feeds
+    startPressureMonitor(MemoryPressurePaths::detect());
+    
     // Start background GC
     startBackgroundGc();
 }
 
 MemoryManager::~MemoryManager() {
+    // The publisher reads stats, so it goes first
+    stopFleetPublisher();
+    
+    // Cancel queued jobs and wait for running ones before the heap goes away
+    gcJobs->shutdown();
+    
+    {
+        std::lock_guard<std::mutex> lock(pressureRestartMutex);
+        stopPressureMonitor();
+    }
+    
     // Stop background GC
     stopBackgroundGc();
     
+    // No collection can queue more finalizers now; run the ones already found
+    finalizationQueue->shutdown();
+    
     // Stop WebSocket server
     stopWebSocketServer();
 }
@@ -301,19 +1149,354 @@ size_t MemoryManager::getTotalMemory() const {
 }
 
 size_t MemoryManager::getUsedMemory() const {
-    return usedMemory;
+    size_t used = 0;
+    for (const auto& arena : arenas) {
+        used += arena->getUsedMemory();
+    }
+    return used;
 }
 
 size_t MemoryManager::getFreeMemory() const {
-    return freeMemory;
+    size_t free = 0;
+    for (const auto& arena : arenas) {
+        free += arena->getFreeMemory();
+    }
+    return free;
 }
 
 float MemoryManager::getFragmentation() const {
-    return fragmentation;
+    size_t total = totalMemory;
+    if (total == 0) {
+        return 0.0f;
+    }
+    
+    // Unused slab space is small-object waste, so it counts alongside fragmented blocks
+    size_t fragmentedSize = slabAllocator->getInternalFragmentation();
+    for (const auto& arena : arenas) {
+        fragmentedSize += arena->getFragmentedMemory();
+    }
+    
+    return static_cast<float>(fragmentedSize) / total * 100.0f;
+}
+
+// Allocation operations
+std::shared_ptr<MemoryBlock> MemoryManager::allocateMemory(size_t size, uint32_t site) {
+    ThreadAllocationCache& cache = getThreadCache();
+    MemoryArena& arena = *arenas[cache.getArenaIndex()];
+    auto& cached = cache.getBlocks();
+    
+    for (int attempt = 0; attempt < 2; ++attempt) {
+        // Fast path: claim the best-fitting cached block without any lock
+        while (true) {
+            // A stale entry may have been claimed through the arena free list meanwhile
+            cached.erase(std::remove_if(cached.begin(), cached.end(),
+                                        [](const std::shared_ptr<MemoryBlock>& block) {
+                                            return block->getStatus() != BlockStatus::FREE;
+                                        }),
+                         cached.end());
+            
+            size_t best = cached.size();
+            for (size_t i = 0; i < cached.size(); ++i) {
+                size_t blockSize = cached[i]->getSize();
+                if (blockSize >= size && (best == cached.size() || blockSize < cached[best]->getSize())) {
+                    best = i;
+                }
+            }
+            if (best == cached.size()) {
+                break;
+            }
+            
+            std::shared_ptr<MemoryBlock> block = std::move(cached[best]);
+            cached[best] = std::move(cached.back());
+            cached.pop_back();
+            
+            // Real memory is the caller's until freeMemory(), so it is claimed pinned and collectors leave it alone
+            if (arena.claimBlock(block, backing != nullptr)) {
+                // Same trim rule as the slow path; the lock is only taken when there is a tail to split off
+                if (block->getSize() >= size + ThreadLocalAllocationBuffer::MIN_RETIRE_SIZE) {
+                    auto arenaLock = lockArena(arena);
+                    trimBlock(arena, block, size);
+                }
+                // A sample left behind means a free went unseen; settle it before the block is reused
+                if (block->isSampled()) {
+                    allocationProfiler->recordFree(*block);
+                }
+                if (cache.consumeSampleBytes(block->getSize())) {
+                    cache.setBytesUntilSample(sampleAllocation(cache, *block, site));
+                }
+                return block;
+            }
+        }
+        
+        // Slow path: refill from the arena, collecting it once if it has nothing that fits
+        if (refillThreadCache(cache, size)) {
+            continue;
+        }
+        if (attempt == 0) {
+            runArenaCollection(cache.getArenaIndex());
+            if (refillThreadCache(cache, size)) {
+                continue;
+            }
+        }
+        break;
+    }
+    
+    return nullptr;
+}
+
+void MemoryManager::freeMemory(const std::shared_ptr<MemoryBlock>& block) {
+    if (!block || block->getArenaId() < 0 || static_cast<size_t>(block->getArenaId()) >= arenas.size()) {
+        return;
+    }
+    
+    MemoryArena& arena = *arenas[block->getArenaId()];
+    // Freed blocks must not be reachable through weak references once reused; the finalizer is dropped.
+    // Locked against reference processing, which may be handing the block to its finalizer.
+    if (block->getReferenceFlags() != 0) {
+        auto arenaLock = lockArena(arena);
+        if (block->getReferenceFlags() & MemoryBlock::FINALIZING) {
+            return; // Already found dead; the finalization queue frees it
+        }
+        referenceProcessor->clearReferences(*block);
+    }
+    // Releasing clears the pin with the same CAS, so a failed release leaves the new owner's pin alone
+    if (!arena.releaseBlock(block)) {
+        return; // Already freed, e.g. by a collection
+    }
+    if (block->isSampled()) {
+        allocationProfiler->recordFree(*block);
+    }
+    
+    // Keep the block for this thread's next allocation when it belongs to the thread's arena
+    ThreadAllocationCache& cache = getThreadCache();
+    if (cache.getArenaIndex() == static_cast<size_t>(block->getArenaId()) &&
+        cache.getBlocks().size() < ThreadAllocationCache::CAPACITY) {
+        cache.getBlocks().push_back(block);
+        return;
+    }
+    
+    auto arenaLock = lockArena(arena);
+    arena.pushFreeBlock(block);
+}
+
+bool MemoryManager::allocateObject(size_t size, ObjectAllocation& allocation, uint32_t site) {
+    size = (size + ThreadLocalAllocationBuffer::ALIGNMENT - 1) & ~(ThreadLocalAllocationBuffer::ALIGNMENT - 1);
+    if (size == 0 || size > ThreadLocalAllocationBuffer::MAX_OBJECT_SIZE) {
+        return false;
+    }
+    
+    // Fast path: bump the thread's own pointer
+    ThreadAllocationCache& cache = getThreadCache();
+    ThreadLocalAllocationBuffer& tlab = cache.getTlab();
+    if (tlab.tryAllocate(size, allocation)) {
+        return true;
+    }
+    
+    // Slow path: the chunk is exhausted or this allocation reaches the thread's next sample
+    bool sampleDue = tlab.consumeSampleBytes(size);
+    if (!tlab.tryAllocate(size, allocation)) {
+        // Retire the exhausted TLAB and reserve a new chunk
+        if (!refillTlab(cache, size)) {
+            runArenaCollection(cache.getArenaIndex());
+            if (!refillTlab(cache, size)) {
+                return false;
+            }
+        }
+        if (!tlab.tryAllocate(size, allocation)) {
+            return false;
+        }
+    }
+    
+    // TLAB objects are never freed one by one; their samples stay in use until the chunk is retired
+    int64_t distance = tlab.getSampleDistance();
+    if (sampleDue) {
+        distance = sampleAllocation(cache, allocation, site);
+        if (allocation.sample != AllocationProfiler::NOT_SAMPLED) {
+            tlab.addSampledObject(allocation);
+        }
+    }
+    tlab.setSampleDistance(distance);
+    return true;
+}
+
+bool MemoryManager::allocateSlabObject(size_t size, ObjectAllocation& allocation, uint32_t site) {
+    if (!slabAllocator->allocate(size, allocation)) {
+        return false;
+    }
+    
+    allocation.sample = AllocationProfiler::NOT_SAMPLED;
+    ThreadAllocationCache& cache = getThreadCache();
+    if (cache.consumeSampleBytes(allocation.size)) {
+        cache.setBytesUntilSample(sampleAllocation(cache, allocation, site));
+    }
+    return true;
+}
+
+bool MemoryManager::freeSlabObject(const ObjectAllocation& allocation) {
+    if (!slabAllocator->free(allocation)) {
+        return false;
+    }
+    if (allocation.sample != AllocationProfiler::NOT_SAMPLED) {
+        allocationProfiler->recordFree(allocation);
+    }
+    return true;
+}
+
+// Reference operations
+void MemoryManager::releaseToCollector(const std::shared_ptr<MemoryBlock>& block) {
+    if (!block || block->getArenaId() < 0 || static_cast<size_t>(block->getArenaId()) >= arenas.size()) {
+        return;
+    }
+    
+    auto arenaLock = lockArena(*arenas[block->getArenaId()]);
+    if (backing && block->getStatus() == BlockStatus::ACTIVE &&
+        !(block->getReferenceFlags() & MemoryBlock::FINALIZING)) {
+        block->setPinned(false);
+    }
+}
+
+std::shared_ptr<WeakBlockReference> MemoryManager::createWeakReference(const std::shared_ptr<MemoryBlock>& block) {
+    if (!block || block->getArenaId() < 0 || static_cast<size_t>(block->getArenaId()) >= arenas.size()) {
+        return nullptr;
+    }
+    
+    // Under the arena lock, so a sweep sees the flag before it can decide the block is dead
+    auto arenaLock = lockArena(*arenas[block->getArenaId()]);
+    if (block->getStatus() != BlockStatus::ACTIVE || (block->getReferenceFlags() & MemoryBlock::FINALIZING)) {
+        // Already dead: the reference starts out cleared
+        auto reference = std::make_shared<WeakBlockReference>(block);
+        reference->clear();
+        return reference;
+    }
+    return referenceProcessor->createWeakReference(block);
+}
+
+std::shared_ptr<MemoryBlock> MemoryManager::getWeakReferent(const WeakBlockReference& reference) {
+    std::shared_ptr<MemoryBlock> block = reference.getBlock();
+    if (!block) {
+        return nullptr;
+    }
+    
+    // Reference processing clears under the arena lock, so a reference still set here names a live block
+    auto arenaLock = lockArena(*arenas[block->getArenaId()]);
+    if (reference.isCleared()) {
+        return nullptr;
+    }
+    if (backing) {
+        block->setPinned(true);
+    }
+    return block;
+}
+
+bool MemoryManager::registerFinalizer(const std::shared_ptr<MemoryBlock>& block, BlockFinalizer finalizer) {
+    if (!block || !finalizer || block->getArenaId() < 0 || static_cast<size_t>(block->getArenaId()) >= arenas.size()) {
+        return false;
+    }
+    
+    auto arenaLock = lockArena(*arenas[block->getArenaId()]);
+    if (block->getStatus() != BlockStatus::ACTIVE || (block->getReferenceFlags() & MemoryBlock::FINALIZING)) {
+        return false;
+    }
+    referenceProcessor->registerFinalizer(block, std::move(finalizer));
+    return true;
+}
+
+void MemoryManager::runFinalization() {
+    finalizationQueue->drain();
+}
+
+size_t MemoryManager::getPendingFinalizations() const {
+    return finalizationQueue->getPendingCount();
+}
+
+uint64_t MemoryManager::getFinalizedBlocks() const {
+    return finalizationQueue->getFinalizedCount();
+}
+
+uint64_t MemoryManager::getClearedWeakReferences() const {
+    return referenceProcessor->getClearedReferences();
+}
+
+// Allocation profiling
+uint32_t MemoryManager::registerAllocationSite(const std::string& name) {
+    return allocationProfiler->registerSite(name);
+}
+
+AllocationProfiler& MemoryManager::getAllocationProfiler() {
+    return *allocationProfiler;
+}
+
+template <typename Allocation>
+int64_t MemoryManager::sampleAllocation(ThreadAllocationCache& cache, Allocation& allocation, uint32_t site) {
+    // The thread's byte counter has run out: take this allocation and draw the next distance
+    if (allocationProfiler->getSamplingInterval() > 0) {
+        allocationProfiler->recordAllocation(allocation, site);
+    }
+    return allocationProfiler->nextSampleDistance(cache.getSampleRandom());
+}
+
+// Arena operations
+size_t MemoryManager::getArenaCount() const {
+    return arenas.size();
+}
+
+const MemoryArena& MemoryManager::getArena(size_t index) const {
+    return *arenas.at(index);
+}
+
+// Real-memory operations
+bool MemoryManager::isMemoryBacked() const {
+    return backing != nullptr;
+}
+
+void* MemoryManager::getBlockAddress(const MemoryBlock& block) const {
+    if (!backing) {
+        return nullptr;
+    }
+    return backing->getAddress(block.getOffset(), block.getSize());
+}
+
+HeapResidency MemoryManager::getHeapResidency() const {
+    if (!backing) {
+        return HeapResidency{false, 0, 0, 0};
+    }
+    std::lock_guard<std::mutex> lock(pressureMutex);
+    return *heapResidency;
+}
+
+size_t MemoryManager::getReleasedMemoryTotal() const {
+    return releasedMemoryTotal;
+}
+
+// Memory pressure operations
+void MemoryManager::setMemoryPressurePaths(const MemoryPressurePaths& paths) {
+    std::lock_guard<std::mutex> lock(pressureRestartMutex);
+    stopPressureMonitor();
+    startPressureMonitor(paths);
+}
+
+MemoryPressureSample MemoryManager::getMemoryPressure() const {
+    std::lock_guard<std::mutex> lock(pressureMutex);
+    return pressureMonitor->getLastSample();
+}
+
+MemoryPressureLevel MemoryManager::getMemoryPressureLevel() const {
+    return pressureLevel;
 }
 
 // GC operations
-size_t MemoryManager::runGarbageCollection() {
+size_t MemoryManager::runGarbageCollection(const GcProgressCallback& progress) {
+    return runCollection(0, arenas.size(), progress);
+}
+
+size_t MemoryManager::runArenaCollection(size_t arenaIndex) {
+    if (arenaIndex >= arenas.size()) {
+        return 0;
+    }
+    return runCollection(arenaIndex, arenaIndex + 1, nullptr);
+}
+
+size_t MemoryManager::runCollection(size_t firstArena, size_t lastArena, const GcProgressCallback& progress) {
     std::lock_guard<std::mutex> lock(memoryMutex);
     
     // Find an enabled algorithm
@@ -328,28 +1511,59 @@ size_t MemoryManager::runGarbageCollection() {
     if (!selectedAlgorithm) {
         return 0;
     }
+    // Under critical memory pressure, reclaim as much as possible whatever the configured priority
+    selectedAlgorithm->setCollectionPriority(pressureLevel == MemoryPressureLevel::CRITICAL
+        ? CollectionPriority::MEMORY : settings->getCollectionPriority());
     
     // Record start time
     auto startTime = std::chrono::system_clock::now();
     
-    // Run the algorithm
-    size_t memoryReclaimed = selectedAlgorithm->collect(memoryBlocks);
+    // Run the algorithm one arena at a time, so mutators on other arenas keep allocating.
+    // Reference processing runs under the same arena lock, so a block's weak references
+    // are cleared before any mutator can reuse its memory.
+    size_t memoryReclaimed = 0;
+    std::chrono::steady_clock::duration pauseTime(0);
+    std::chrono::steady_clock::duration referenceProcessingTime(0);
+    for (size_t i = firstArena; i < lastArena; ++i) {
+        // Checked before each arena, so a cancelled collection stops before starting more work
+        // and still records the arenas it finished
+        float done = static_cast<float>(i - firstArena) / static_cast<float>(lastArena - firstArena);
+        if (progress && !progress(done)) {
+            break;
+        }
+        
+        MemoryArena& arena = *arenas[i];
+        auto arenaLock = lockArena(arena);
+        auto sweepStart = std::chrono::steady_clock::now();
+        
+        size_t arenaReclaimed = selectedAlgorithm->collectArena(arena);
+        auto referencesStart = std::chrono::steady_clock::now();
+        arenaReclaimed += processReferences(arena, selectedAlgorithm->getDiscoveredBlocks(), pendingFinalizations);
+        auto referencesEnd = std::chrono::steady_clock::now();
+        arena.rebuildFreeList();
+        releaseFreeRanges(arena);
+        arenaLock.unlock();
+        
+        pauseTime += (referencesStart - sweepStart) + (std::chrono::steady_clock::now() - referencesEnd);
+        referenceProcessingTime += referencesEnd - referencesStart;
+        memoryReclaimed += arenaReclaimed;
+    }
     
     // Record end time
     auto endTime = std::chrono::system_clock::now();
     auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(endTime - startTime).count();
     
-    // Update memory usage
-    usedMemory -= memoryReclaimed;
-    freeMemory += memoryReclaimed;
-    
-    // Update fragmentation
-    updateFragmentation();
+    // Finalizers found by this collection run on the finalization thread, never under memoryMutex
+    finalizationQueue->submit(pendingFinalizations);
     
     // Update GC stats
     gcRunsToday++;
-    lastGcRun = endTime;
+    lastGcRun = endTime.time_since_epoch().count();
     averageGcDuration = (averageGcDuration * (gcRunsToday - 1) + duration) / gcRunsToday;
+    memoryReclaimedTotal += memoryReclaimed;
+    // The arena-locked time, as in the activity record, so fleet histograms and activities agree
+    pauseHistograms[static_cast<size_t>(PauseType::COLLECTION)].record(
+        std::chrono::duration_cast<std::chrono::microseconds>(pauseTime));
     
     // Simulate CPU impact
     std::random_device rd;
@@ -358,14 +1572,15 @@ size_t MemoryManager::runGarbageCollection() {
     cpuImpact = static_cast<float>(dis(gen));
     
     // Create activity record
-    int activityId = activities.size() + 1;
     int objectsCollected = static_cast<int>(memoryReclaimed / 1024); // Rough estimate
-    auto activity = std::make_shared<GcActivity>(
-        activityId, selectedAlgorithm->getId(), endTime, duration, memoryReclaimed, objectsCollected, cpuImpact);
     
     // Add activity
     {
         std::lock_guard<std::mutex> activitiesLock(activitiesMutex);
+        auto activity = std::make_shared<GcActivity>(
+            nextActivityId++, selectedAlgorithm->getId(), endTime, duration, memoryReclaimed, objectsCollected, cpuImpact,
+            std::chrono::duration_cast<std::chrono::microseconds>(pauseTime),
+            std::chrono::duration_cast<std::chrono::microseconds>(referenceProcessingTime));
         activities.insert(activities.begin(), activity);
         
         // Keep only the last 1000 activities
@@ -375,80 +1590,259 @@ size_t MemoryManager::runGarbageCollection() {
     }
     
     // Create memory record
-    int recordId = memoryRecords.size() + 1;
-    auto record = std::make_shared<MemoryRecord>(
-        recordId, endTime, totalMemory, usedMemory, freeMemory, fragmentation);
+    updateMemoryUsage();
     
-    // Add memory record
-    {
-        std::lock_guard<std::mutex> recordsLock(recordsMutex);
-        memoryRecords.insert(memoryRecords.begin(), record);
-        
-        // Keep only the last 1000 records
-        if (memoryRecords.size() > 1000) {
-            memoryRecords.resize(1000);
+    return memoryReclaimed;
+}
+
+size_t MemoryManager::runGcJob(GcJobType type, const GcProgressCallback& progress) {
+    switch (type) {
+        case GcJobType::COLLECTION:
+            return runGarbageCollection(progress);
+        case GcJobType::OPTIMIZATION:
+            return optimizeMemory(progress);
+        case GcJobType::DEFRAGMENTATION:
+            return defragmentMemory(progress);
+    }
+    return 0;
+}
+
+size_t MemoryManager::processReferences(MemoryArena& arena, std::vector<std::shared_ptr<MemoryBlock>>& discovered,
+                                        std::vector<PendingFinalization>& finalizations) {
+    size_t memoryFreed = 0;
+    for (const auto& block : discovered) {
+        BlockFinalizer finalizer = referenceProcessor->clearReferences(*block);
+        if (finalizer) {
+            // Kept allocated until the finalizer has run; pinned so later sweeps pass over it
+            block->addReferenceFlags(MemoryBlock::FINALIZING);
+            block->setPinned(true);
+            finalizations.push_back(PendingFinalization{block, std::move(finalizer)});
+        } else if (block->compareAndSetStatus(BlockStatus::ACTIVE, BlockStatus::FREE)) {
+            memoryFreed += block->getSize();
+            if (block->isSampled()) {
+                allocationProfiler->recordFree(*block);
+            }
         }
     }
+    discovered.clear();
     
-    return memoryReclaimed;
+    arena.accountCollected(memoryFreed);
+    return memoryFreed;
 }
 
-size_t MemoryManager::optimizeMemory() {
+void MemoryManager::releaseFinalizedBlock(const std::shared_ptr<MemoryBlock>& block) {
+    MemoryArena& arena = *arenas[block->getArenaId()];
+    auto arenaLock = lockArena(arena);
+    
+    block->clearReferenceFlags();
+    if (!arena.releaseBlock(block)) {
+        return;
+    }
+    memoryReclaimedTotal += block->getSize();
+    if (block->isSampled()) {
+        allocationProfiler->recordFree(*block);
+    }
+    arena.pushFreeBlock(block);
+}
+
+void MemoryManager::releaseFreeRanges(MemoryArena& arena) {
+    if (!backing) {
+        return;
+    }
+    
+    // Under pressure, drop pages at once: MADV_FREE pages count against the cgroup until reclaimed
+    bool immediate = pressureLevel != MemoryPressureLevel::NONE;
+    
+    auto& blocks = arena.getBlocks();
+    size_t i = 0;
+    while (i < blocks.size()) {
+        if (blocks[i]->getStatus() != BlockStatus::FREE) {
+            ++i;
+            continue;
+        }
+        
+        // Extent of the run of address-adjacent free blocks starting here
+        size_t runEnd = i + 1;
+        bool resident = blocks[i]->isResident();
+        while (runEnd < blocks.size() && blocks[runEnd]->getStatus() == BlockStatus::FREE &&
+               blocks[runEnd]->getOffset() == blocks[runEnd - 1]->getOffset() + blocks[runEnd - 1]->getSize()) {
+            resident = resident || blocks[runEnd]->isResident();
+            ++runEnd;
+        }
+        
+        // Park the blocks as fragmented while their pages go back, so a mutator cannot claim
+        // one and write to it mid-madvise; a block claimed first splits the run
+        while (resident && i < runEnd) {
+            size_t offset = blocks[i]->getOffset();
+            size_t bytes = 0;
+            size_t parkedFrom = i;
+            while (i < runEnd && blocks[i]->compareAndSetStatus(BlockStatus::FREE, BlockStatus::FRAGMENTED)) {
+                bytes += blocks[i]->getSize();
+                ++i;
+            }
+            
+            if (bytes > 0) {
+                releasedMemoryTotal += backing->release(offset, bytes, immediate);
+            }
+            for (size_t j = parkedFrom; j < i; ++j) {
+                blocks[j]->setResident(false);
+                blocks[j]->setStatus(BlockStatus::FREE);
+            }
+            
+            if (i < runEnd) {
+                ++i; // Claimed by a mutator
+            }
+        }
+        i = runEnd;
+    }
+}
+
+size_t MemoryManager::optimizeMemory(const GcProgressCallback& progress) {
     std::lock_guard<std::mutex> lock(memoryMutex);
+    auto startTime = std::chrono::steady_clock::now();
     
     // Simulate memory optimization
     size_t memoryReclaimed = 0;
     
     // Find fragmented blocks and consolidate them
-    for (auto& block : memoryBlocks) {
-        if (block->getStatus() == BlockStatus::FRAGMENTED) {
-            memoryReclaimed += block->getSize();
-            block->setStatus(BlockStatus::FREE);
+    for (size_t i = 0; i < arenas.size(); ++i) {
+        if (progress && !progress(static_cast<float>(i) / static_cast<float>(arenas.size()))) {
+            break;
+        }
+        
+        MemoryArena& arena = *arenas[i];
+        {
+            auto arenaLock = lockArena(arena);
+            
+            for (auto& block : arena.getBlocks()) {
+                if (block->getStatus() == BlockStatus::FRAGMENTED && arena.reclaimFragmentedBlock(block)) {
+                    memoryReclaimed += block->getSize();
+                    arena.pushFreeBlock(block);
+                }
+            }
+            releaseFreeRanges(arena);
         }
     }
     
-    // Update memory usage
-    usedMemory -= memoryReclaimed;
-    freeMemory += memoryReclaimed;
-    
-    // Update fragmentation
-    updateFragmentation();
+    memoryReclaimedTotal += memoryReclaimed;
+    pauseHistograms[static_cast<size_t>(PauseType::OPTIMIZATION)].record(
+        std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - startTime));
     
     return memoryReclaimed;
 }
 
-size_t MemoryManager::defragmentMemory() {
+size_t MemoryManager::defragmentMemory(const GcProgressCallback& progress) {
     std::lock_guard<std::mutex> lock(memoryMutex);
+    auto startTime = std::chrono::steady_clock::now();
     
     // Simulate memory defragmentation
     size_t memoryReclaimed = 0;
     
-    // Consolidate free blocks
-    for (auto& block : memoryBlocks) {
-        if (block->getStatus() == BlockStatus::FREE) {
-            // Find adjacent free blocks and merge them
-            for (auto& otherBlock : memoryBlocks) {
-                if (otherBlock != block && otherBlock->getStatus() == BlockStatus::FREE) {
-                    block->setStatus(BlockStatus::ACTIVE); // Mark as active temporarily
-                    otherBlock->setStatus(BlockStatus::ACTIVE); // Mark as active temporarily
-                    memoryReclaimed += otherBlock->getSize();
-                    otherBlock->setStatus(BlockStatus::FREE); // Mark as free again
-                    block->setStatus(BlockStatus::FREE); // Mark as free again
-                }
-            }
+    // Consolidate free blocks within each arena; blocks never move between arenas
+    for (size_t i = 0; i < arenas.size(); ++i) {
+        if (progress && !progress(static_cast<float>(i) / static_cast<float>(arenas.size()))) {
+            break;
+        }
+        
+        MemoryArena& arena = *arenas[i];
+        {
+            auto arenaLock = lockArena(arena);
+            memoryReclaimed += mergeFreeBlocks(arena);
+            releaseFreeRanges(arena);
         }
     }
     
-    // Update memory usage
-    usedMemory -= memoryReclaimed;
-    freeMemory += memoryReclaimed;
-    
-    // Update fragmentation
-    updateFragmentation();
+    pauseHistograms[static_cast<size_t>(PauseType::DEFRAGMENTATION)].record(
+        std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - startTime));
     
     return memoryReclaimed;
 }
 
+size_t MemoryManager::mergeFreeBlocks(MemoryArena& arena) {
+    // Splits and evacuations append to the table, so put it back in address order first;
+    // then one pass finds every run of address-adjacent free blocks
+    auto& blocks = arena.getBlocks();
+    std::sort(blocks.begin(), blocks.end(),
+              [](const std::shared_ptr<MemoryBlock>& a, const std::shared_ptr<MemoryBlock>& b) {
+                  return a->getOffset() < b->getOffset();
+              });
+    
+    auto adjacentFree = [&blocks](size_t first, size_t second) {
+        return blocks[first]->getStatus() == BlockStatus::FREE && blocks[second]->getStatus() == BlockStatus::FREE &&
+               blocks[second]->getOffset() == blocks[first]->getOffset() + blocks[first]->getSize();
+    };
+    
+    std::vector<std::shared_ptr<MemoryBlock>> newBlocks;
+    newBlocks.reserve(blocks.size());
+    size_t addedFreeBytes = 0;
+    size_t mergedBytes = 0;
+    
+    size_t i = 0;
+    while (i < blocks.size()) {
+        if (i + 1 == blocks.size() || !adjacentFree(i, i + 1)) {
+            newBlocks.push_back(blocks[i++]);
+            continue;
+        }
+        
+        // Retire the run and replace it with one free block; a block a mutator claims
+        // in the meantime stays where it is and splits the run
+        size_t runOffset = 0;
+        size_t runBytes = 0;
+        size_t runBlocks = 0;
+        bool runResident = false;
+        auto flushRun = [&]() {
+            if (runBytes == 0) {
+                return;
+            }
+            auto merged = std::make_shared<MemoryBlock>(nextBlockId++, runBytes, BlockStatus::FREE, arena.getId(), runOffset);
+            merged->setResident(runResident);
+            newBlocks.push_back(merged);
+            addedFreeBytes += runBytes;
+            runBytes = 0;
+            runBlocks = 0;
+            runResident = false;
+        };
+        
+        size_t runEnd = i + 1;
+        while (runEnd < blocks.size() && adjacentFree(runEnd - 1, runEnd)) {
+            ++runEnd;
+        }
+        for (; i < runEnd; ++i) {
+            const auto& block = blocks[i];
+            if (!arena.retireFreeBlock(block)) {
+                flushRun();
+                newBlocks.push_back(block);
+                continue;
+            }
+            if (runBlocks == 0 || block->getOffset() != runOffset + runBytes) {
+                flushRun();
+                runOffset = block->getOffset();
+            } else {
+                mergedBytes += block->getSize();
+            }
+            runBytes += block->getSize();
+            runResident = runResident || block->isResident();
+            ++runBlocks;
+        }
+        flushRun();
+    }
+    
+    if (addedFreeBytes > 0) {
+        arena.replaceBlocks(std::move(newBlocks), addedFreeBytes);
+        arena.rebuildFreeList();
+    }
+    return mergedBytes;
+}
+
+// GC job operations
+uint64_t MemoryManager::submitGcJob(GcJobType type, int priority) {
+    return gcJobs->submit(type, priority);
+}
+
+bool MemoryManager::cancelGcJob(uint64_t jobId) {
+    return gcJobs->cancel(jobId);
+}
+
 // Algorithm operations
 std::vector<std::shared_ptr<GcAlgorithm>> MemoryManager::getAllAlgorithms() const {
     return algorithms;
@@ -504,8 +1898,37 @@ std::vector<std::shared_ptr<MemoryRecord>> MemoryManager::getRecentMemoryRecords
 
 // Memory block operations
 std::vector<std::shared_ptr<MemoryBlock>> MemoryManager::getAllBlocks() const {
-    std::lock_guard<std::mutex> lock(memoryMutex);
-    return memoryBlocks;
+    std::vector<std::shared_ptr<MemoryBlock>> result;
+    
+    for (const auto& arena : arenas) {
+        auto lock = lockArena(*arena);
+        const auto& blocks = arena->getBlocks();
+        result.insert(result.end(), blocks.begin(), blocks.end());
+    }
+    
+    return result;
+}
+
+// Heap map operations
+HeapMapUpdate MemoryManager::getHeapMap(uint32_t width, uint64_t sinceVersion) {
+    width = std::max(1u, std::min(width, MAX_HEAP_MAP_WIDTH));
+    std::lock_guard<std::mutex> lock(heapMapsMutex);
+    
+    // Clients settle on a handful of widths; past that, the map refreshed longest ago makes room.
+    // Versions come from heapMapVersions, so clients of an evicted map get a full update later.
+    if (heapMaps.size() >= MAX_HEAP_MAPS && heapMaps.find(width) == heapMaps.end()) {
+        auto oldest = std::min_element(heapMaps.begin(), heapMaps.end(), [](const auto& a, const auto& b) {
+            return a.second->getLastRefresh() < b.second->getLastRefresh();
+        });
+        heapMaps.erase(oldest);
+    }
+    
+    auto& heapMap = heapMaps[width];
+    if (!heapMap) {
+        heapMap = std::make_unique<HeapMap>(width, heapMapVersions);
+    }
+    
+    return getHeapMapLocked(*heapMap, sinceVersion);
 }
 
 // Settings operations
@@ -518,13 +1941,179 @@ bool MemoryManager::updateSettings(const GcSettings& newSettings) {
     return true;
 }
 
+// Snapshot operations
+std::future<bool> MemoryManager::saveSnapshot(const std::string& path) const {
+    auto snapshot = std::make_shared<HeapSnapshot>();
+    
+    SnapshotSettings& snapshotSettings = snapshot->getSettings();
+    snapshotSettings.autoCollection = settings->isAutoCollection();
+    snapshotSettings.backgroundCollection = settings->isBackgroundCollection();
+    snapshotSettings.collectionPriority = static_cast<uint8_t>(settings->getCollectionPriority());
+    snapshotSettings.memoryThreshold = settings->getMemoryThreshold();
+    snapshotSettings.timeInterval = settings->getTimeInterval();
+    snapshotSettings.cpuLimit = settings->getCpuLimit();
+    
+    SnapshotStats& stats = snapshot->getStats();
+    stats.totalMemory = totalMemory;
+    stats.memoryReclaimedTotal = memoryReclaimedTotal;
+    stats.lastGcRun = lastGcRun;
+    stats.gcRunsToday = gcRunsToday;
+    stats.averageGcDuration = averageGcDuration;
+    stats.cpuImpact = cpuImpact;
+    stats.nextBlockId = nextBlockId;
+    
+    for (const auto& algorithm : algorithms) {
+        SnapshotAlgorithm record = {};
+        record.id = algorithm->getId();
+        record.performanceScore = algorithm->getPerformanceScore();
+        record.enabled = algorithm->isEnabled();
+        snapshot->getAlgorithms().push_back(record);
+    }
+    
+    // Each arena is copied under its own lock only, so collection and allocation carry on
+    // elsewhere; the restore recomputes all counters from the blocks themselves
+    auto& blocks = snapshot->getBlocks();
+    for (const auto& arena : arenas) {
+        auto arenaLock = lockArena(*arena);
+        blocks.reserve(blocks.size() + arena->getBlocks().size());
+        
+        for (const auto& block : arena->getBlocks()) {
+            SnapshotBlock record = {};
+            record.size = block->getSize();
+            record.id = block->getId();
+            record.arenaId = block->getArenaId();
+            record.status = static_cast<uint8_t>(block->getStatus());
+            blocks.push_back(record);
+        }
+    }
+    snapshot->setArenaCount(static_cast<uint32_t>(arenas.size()));
+    
+    return std::async(std::launch::async, [snapshot, path]() {
+        return snapshot->write(path);
+    });
+}
+
+bool MemoryManager::restoreSnapshot(const std::string& path) {
+    MappedHeapSnapshot snapshot;
+    if (!snapshot.open(path)) {
+        return false;
+    }
+    
+    // Restored blocks are laid out from offset 0, so a snapshot of a larger heap would run past
+    // the reservation; reject it before anything is touched
+    const SnapshotStats& stats = snapshot.getStats();
+    const SnapshotBlock* blockRecords = snapshot.getBlocks();
+    uint64_t blockCount = snapshot.getHeader().blockCount;
+    uint64_t snapshotBytes = 0;
+    for (uint64_t i = 0; i < blockCount; ++i) {
+        if (blockRecords[i].size > heapCapacity - snapshotBytes) {
+            return false;
+        }
+        snapshotBytes += blockRecords[i].size;
+    }
+    
+    // Finalizers still queued refer to blocks of the table about to be replaced, so they run
+    // first. One that allocates can start a collection, which needs memoryMutex, so the drain
+    // waits without it; only collections queue finalizers, and they hold memoryMutex to do it,
+    // so an empty queue seen under the lock stays empty until the restore is done.
+    std::unique_lock<std::mutex> lock(memoryMutex);
+    while (finalizationQueue->getPendingCount() != 0) {
+        lock.unlock();
+        finalizationQueue->drain();
+        lock.lock();
+    }
+    
+    // Settings
+    const SnapshotSettings& snapshotSettings = snapshot.getSettings();
+    CollectionPriority collectionPriority = CollectionPriority::BALANCED;
+    if (snapshotSettings.collectionPriority <= static_cast<uint8_t>(CollectionPriority::MEMORY)) {
+        collectionPriority = static_cast<CollectionPriority>(snapshotSettings.collectionPriority);
+    }
+    updateSettings(GcSettings(snapshotSettings.autoCollection != 0, snapshotSettings.memoryThreshold,
+                              snapshotSettings.timeInterval, snapshotSettings.backgroundCollection != 0,
+                              snapshotSettings.cpuLimit, collectionPriority));
+    
+    // Algorithm state
+    const SnapshotAlgorithm* algorithmRecords = snapshot.getAlgorithms();
+    for (uint32_t i = 0; i < snapshot.getHeader().algorithmCount; ++i) {
+        updateAlgorithm(algorithmRecords[i].id, algorithmRecords[i].enabled != 0,
+                        algorithmRecords[i].performanceScore);
+    }
+    
+    // Stats counters. The heap size is whatever the restored blocks add up to, not the
+    // file's own figure, so the two can never disagree.
+    totalMemory = snapshotBytes;
+    memoryReclaimedTotal = stats.memoryReclaimedTotal;
+    lastGcRun = stats.lastGcRun;
+    gcRunsToday = stats.gcRunsToday;
+    averageGcDuration = stats.averageGcDuration;
+    cpuImpact = stats.cpuImpact;
+    
+    // Block table. Blocks keep their arena when the arena count matches and are spread
+    // modulo the current count otherwise.
+    std::vector<size_t> arenaBlockCounts(arenas.size(), 0);
+    int maxBlockId = 0;
+    for (uint64_t i = 0; i < blockCount; ++i) {
+        arenaBlockCounts[static_cast<uint32_t>(blockRecords[i].arenaId) % arenas.size()]++;
+        maxBlockId = std::max(maxBlockId, blockRecords[i].id);
+    }
+    
+    // Snapshots hold the block layout, not memory contents; restored blocks are laid out
+    // back to back per arena and any real pages from before are dropped
+    std::vector<size_t> arenaOffsets(arenas.size(), 0);
+    for (uint64_t i = 0; i < blockCount; ++i) {
+        size_t arenaIndex = static_cast<uint32_t>(blockRecords[i].arenaId) % arenas.size();
+        if (arenaIndex + 1 < arenas.size()) {
+            arenaOffsets[arenaIndex + 1] += blockRecords[i].size;
+        }
+    }
+    for (size_t i = 1; i < arenas.size(); ++i) {
+        arenaOffsets[i] += arenaOffsets[i - 1];
+    }
+    
+    std::vector<std::unique_lock<std::mutex>> arenaLocks;
+    for (size_t i = 0; i < arenas.size(); ++i) {
+        arenaLocks.emplace_back(arenas[i]->getMutex());
+        arenas[i]->clear();
+        arenas[i]->reserveBlocks(arenaBlockCounts[i]);
+    }
+    if (backing) {
+        backing->releaseAll();
+    }
+    allocationProfiler->clearLive();
+    referenceProcessor->clear();
+    
+    for (uint64_t i = 0; i < blockCount; ++i) {
+        const SnapshotBlock& record = blockRecords[i];
+        BlockStatus status = record.status <= static_cast<uint8_t>(BlockStatus::FRAGMENTED)
+            ? static_cast<BlockStatus>(record.status) : BlockStatus::FREE;
+        size_t arenaIndex = static_cast<uint32_t>(record.arenaId) % arenas.size();
+        MemoryArena& arena = *arenas[arenaIndex];
+        
+        arena.addBlock(std::make_shared<MemoryBlock>(record.id, record.size, status, arena.getId(), arenaOffsets[arenaIndex]));
+        arenaOffsets[arenaIndex] += record.size;
+    }
+    
+    nextBlockId = std::max(stats.nextBlockId, maxBlockId + 1);
+    
+    arenaLocks.clear();
+    
+    // Caches and slabs still refer to the old block table. Other threads may be using them,
+    // so neither is replaced: each cache empties itself once its owner sees the new epoch,
+    // and slabs on the retired blocks are dropped here
+    cacheEpoch++;
+    slabAllocator->dropDeadSlabs();
+    
+    return true;
+}
+
 // Stats operations
 int MemoryManager::getGcRunsToday() const {
     return gcRunsToday;
 }
 
 std::chrono::system_clock::time_point MemoryManager::getLastGcRun() const {
-    return lastGcRun;
+    return std::chrono::system_clock::time_point(std::chrono::system_clock::duration(lastGcRun.load()));
 }
 
 int MemoryManager::getAverageGcDuration() const {
@@ -535,6 +2124,59 @@ float MemoryManager::getCpuImpact() const {
     return cpuImpact;
 }
 
+size_t MemoryManager::getMemoryReclaimedTotal() const {
+    return memoryReclaimedTotal;
+}
+
+const PauseHistogram& MemoryManager::getPauseHistogram(PauseType type) const {
+    return pauseHistograms[static_cast<size_t>(type)];
+}
+
+uint64_t MemoryManager::getTlabRefills() const {
+    return tlabRefills;
+}
+
+size_t MemoryManager::getTlabAllocatedBytes() const {
+    return tlabAllocatedBytes;
+}
+
+size_t MemoryManager::getTlabRetiredBytes() const {
+    return tlabRetiredBytes;
+}
+
+size_t MemoryManager::getTlabWasteBytes() const {
+    return tlabWasteBytes;
+}
+
+size_t MemoryManager::getSlabMemory() const {
+    return slabAllocator->getSlabMemory();
+}
+
+float MemoryManager::getSlabOccupancy() const {
+    return slabAllocator->getOccupancy();
+}
+
+size_t MemoryManager::getSlabInternalFragmentation() const {
+    return slabAllocator->getInternalFragmentation();
+}
+
+// Fleet operations
+bool MemoryManager::startFleetPublisher(const std::string& socketPath, const std::string& name) {
+    if (fleetPublisher) {
+        return false;
+    }
+    fleetPublisher = std::make_unique<FleetPublisher>(*this, socketPath, name);
+    fleetPublisher->start();
+    return true;
+}
+
+void MemoryManager::stopFleetPublisher() {
+    if (fleetPublisher) {
+        fleetPublisher->stop();
+        fleetPublisher.reset();
+    }
+}
+
 // WebSocket interface
 void MemoryManager::startWebSocketServer(int port) {
     // In a real implementation, this would start a WebSocket server
@@ -549,74 +2191,117 @@ void MemoryManager::stopWebSocketServer() {
 }
 
 // Private methods
-void MemoryManager::initializeMemory(size_t totalMemory) {
+void MemoryManager::initializeMemory(size_t totalMemory, bool lazyInitialization) {
     this->totalMemory = totalMemory;
-    this->usedMemory = static_cast<size_t>(totalMemory * 0.42); // 42% used initially
-    this->freeMemory = totalMemory - this->usedMemory;
     
-    // Create initial memory blocks
-    memoryBlocks.clear();
-    
-    // Create some random blocks
+    // Give every arena an equal region with its own seed, so regions can be generated
+    // independently and in any order
     std::random_device rd;
-    std::mt19937 gen(rd());
-    std::uniform_int_distribution<> sizeDis(1024, 1024 * 1024); // 1 KB to 1 MB
-    std::uniform_real_distribution<> statusDis(0.0, 1.0);
+    uint32_t baseSeed = rd();
+    size_t arenaShare = totalMemory / arenas.size();
     
-    size_t remainingSize = totalMemory;
-    int blockId = 1;
-    
-    while (remainingSize > 0) {
-        size_t blockSize = std::min(static_cast<size_t>(sizeDis(gen)), remainingSize);
-        
-        BlockStatus status;
-        if (statusDis(gen) < 0.3) {
-            status = BlockStatus::FREE;
-        } else if (statusDis(gen) < 0.8) {
-            status = BlockStatus::ACTIVE;
-        } else {
-            status = BlockStatus::FRAGMENTED;
-        }
+    for (size_t i = 0; i < arenas.size(); ++i) {
+        // The last arena absorbs the remainder of the division
+        size_t regionSize = (i + 1 == arenas.size()) ? totalMemory - arenaShare * i : arenaShare;
+        std::seed_seq seq{baseSeed, static_cast<uint32_t>(i)};
+        uint32_t regionSeed;
+        seq.generate(&regionSeed, &regionSeed + 1);
         
-        auto block = std::make_shared<MemoryBlock>(blockId++, blockSize, status);
-        memoryBlocks.push_back(block);
-        
-        remainingSize -= blockSize;
+        // Regions are laid out back to back, which is also their place in a real-memory reservation
+        arenas[i]->setPendingRegion(arenaShare * i, regionSize, regionSeed);
     }
     
-    // Update fragmentation
-    updateFragmentation();
+    if (!lazyInitialization) {
+        materializeArenas();
+    }
 }
 
-void MemoryManager::allocateMemory(size_t size) {
-    // In a real implementation, this would allocate memory
-    // For simulation, we'll just update the counters
-    usedMemory += size;
-    freeMemory -= size;
+void MemoryManager::materializeArenas() {
+    size_t workerCount = std::min<size_t>(arenas.size(), std::max(1u, std::thread::hardware_concurrency()));
+    std::atomic<size_t> nextArena(0);
     
-    // Update memory usage
-    updateMemoryUsage();
+    auto worker = [this, &nextArena]() {
+        for (size_t i = nextArena++; i < arenas.size(); i = nextArena++) {
+            // Taking the lock is what materialises the arena
+            lockArena(*arenas[i]);
+        }
+    };
+    
+    std::vector<std::thread> workers;
+    for (size_t i = 1; i < workerCount; ++i) {
+        workers.emplace_back(worker);
+    }
+    worker();
+    
+    for (auto& thread : workers) {
+        thread.join();
+    }
 }
 
-void MemoryManager::freeMemory(size_t size) {
-    // In a real implementation, this would free memory
-    // For simulation, we'll just update the counters
-    usedMemory -= size;
-    freeMemory += size;
+void MemoryManager::materializeArena(MemoryArena& arena) const {
+    if (arena.isMaterialized()) {
+        return;
+    }
     
-    // Update memory usage
-    updateMemoryUsage();
+    // Create some random blocks. Both passes replay the same sequence from the region seed:
+    // the first only counts blocks so the tables and ids can be reserved exactly.
+    auto generateBlocks = [&arena](const std::function<void(size_t, BlockStatus)>& emit) {
+        std::mt19937 gen(arena.getRegionSeed());
+        std::uniform_int_distribution<> sizeDis(1024, 1024 * 1024); // 1 KB to 1 MB
+        std::uniform_real_distribution<> statusDis(0.0, 1.0);
+        
+        size_t remainingSize = arena.getRegionSize();
+        while (remainingSize > 0) {
+            size_t blockSize = std::min(static_cast<size_t>(sizeDis(gen)), remainingSize);
+            
+            BlockStatus status;
+            if (statusDis(gen) < 0.3) {
+                status = BlockStatus::FREE;
+            } else if (statusDis(gen) < 0.8) {
+                status = BlockStatus::ACTIVE;
+            } else {
+                status = BlockStatus::FRAGMENTED;
+            }
+            
+            emit(blockSize, status);
+            remainingSize -= blockSize;
+        }
+    };
+    
+    size_t blockCount = 0;
+    generateBlocks([&blockCount](size_t, BlockStatus) { ++blockCount; });
+    
+    int blockId = nextBlockId.fetch_add(static_cast<int>(blockCount));
+    size_t offset = arena.getRegionOffset();
+    arena.reserveBlocks(blockCount);
+    generateBlocks([&](size_t blockSize, BlockStatus status) {
+        arena.addBlock(std::make_shared<MemoryBlock>(blockId++, blockSize, status, arena.getId(), offset));
+        offset += blockSize;
+    });
+    
+    arena.markMaterialized();
+}
+
+std::unique_lock<std::mutex> MemoryManager::lockArena(MemoryArena& arena) const {
+    std::unique_lock<std::mutex> lock(arena.getMutex());
+    if (!arena.isMaterialized()) {
+        materializeArena(arena);
+    }
+    return lock;
 }
 
 void MemoryManager::updateMemoryUsage() {
-    // Create memory record
-    int recordId = memoryRecords.size() + 1;
-    auto record = std::make_shared<MemoryRecord>(
-        recordId, std::chrono::system_clock::now(), totalMemory, usedMemory, freeMemory, fragmentation);
+    // Sum the arena counters before taking the records lock
+    size_t used = getUsedMemory();
+    size_t free = getFreeMemory();
+    float currentFragmentation = getFragmentation();
     
     // Add memory record
     {
         std::lock_guard<std::mutex> recordsLock(recordsMutex);
+        int recordId = memoryRecords.size() + 1;
+        auto record = std::make_shared<MemoryRecord>(
+            recordId, std::chrono::system_clock::now(), totalMemory, used, free, currentFragmentation);
         memoryRecords.insert(memoryRecords.begin(), record);
         
         // Keep only the last 1000 records
@@ -626,17 +2311,225 @@ void MemoryManager::updateMemoryUsage() {
     }
 }
 
-void MemoryManager::updateFragmentation() {
-    // Calculate fragmentation
-    size_t fragmentedSize = 0;
+ThreadAllocationCache& MemoryManager::getThreadCache() {
+    if (threadCacheSlot.managerInstanceId == instanceId) {
+        ThreadAllocationCache& cache = *threadCacheSlot.cache;
+        uint64_t epoch = cacheEpoch.load(std::memory_order_acquire);
+        if (cache.getEpoch() != epoch) {
+            cache.invalidate(epoch);
+        }
+        return cache;
+    }
+    return bindThreadCache();
+}
+
+ThreadAllocationCache& MemoryManager::bindThreadCache() {
+    // First allocation from this thread (or it last used another manager): bind it to an arena
+    std::lock_guard<std::mutex> lock(threadCachesMutex);
     
-    for (const auto& block : memoryBlocks) {
-        if (block->getStatus() == BlockStatus::FRAGMENTED) {
-            fragmentedSize += block->getSize();
+    // Let go of the previous cache first, so a thread returning to this manager can get it back
+    threadCacheSlot.bind(0, nullptr);
+    
+    // A cache left behind by an exited thread keeps its arena, blocks and TLAB for the next one
+    uint64_t epoch = cacheEpoch.load(std::memory_order_acquire);
+    for (const auto& cache : threadCaches) {
+        if (cache->tryAcquire()) {
+            if (cache->getEpoch() != epoch) {
+                cache->invalidate(epoch);
+            }
+            threadCacheSlot.bind(instanceId, cache);
+            return *cache;
+        }
+    }
+    
+    size_t arenaIndex = nextArenaAssignment++ % arenas.size();
+    auto cache = std::make_shared<ThreadAllocationCache>(arenaIndex);
+    cache->tryAcquire();
+    cache->invalidate(epoch);
+    // Blocks and slab objects share one sample countdown; bump allocation in the TLAB has its own
+    cache->setBytesUntilSample(allocationProfiler->nextSampleDistance(cache->getSampleRandom()));
+    cache->getTlab().setSampleDistance(allocationProfiler->nextSampleDistance(cache->getSampleRandom()));
+    threadCaches.push_back(cache);
+    
+    threadCacheSlot.bind(instanceId, cache);
+    return *cache;
+}
+
+bool MemoryManager::refillThreadCache(ThreadAllocationCache& cache, size_t minSize) {
+    MemoryArena& arena = *arenas[cache.getArenaIndex()];
+    auto& cached = cache.getBlocks();
+    auto lock = lockArena(arena);
+    
+    auto fitting = arena.takeFreeBlock(minSize);
+    if (!fitting) {
+        return false;
+    }
+    cached.push_back(fitting);
+    
+    // Top up with whatever else is free so the next few allocations stay lock-free
+    while (cached.size() < ThreadAllocationCache::REFILL_BATCH) {
+        auto block = arena.takeFreeBlock(0);
+        if (!block) {
+            break;
+        }
+        cached.push_back(block);
+    }
+    
+    return true;
+}
+
+bool MemoryManager::refillTlab(ThreadAllocationCache& cache, size_t minSize) {
+    ThreadLocalAllocationBuffer& tlab = cache.getTlab();
+    MemoryArena& arena = *arenas[cache.getArenaIndex()];
+    auto now = std::chrono::steady_clock::now();
+    auto lock = lockArena(arena);
+    
+    // Retire the current TLAB, handing a usable leftover back to the free list
+    if (auto chunk = tlab.getChunk()) {
+        size_t used = tlab.getUsed();
+        size_t leftover = tlab.getRemaining();
+        tlabAllocatedBytes += used;
+        tlab.updateDesiredSize(now);
+        
+        // The chunk may have been freed behind the TLAB's back, in which case there is nothing to return
+        if (chunk->getStatus() != BlockStatus::ACTIVE) {
+            tlabWasteBytes += leftover;
+        } else if (used == 0) {
+            arena.releaseBlock(chunk);
+            arena.pushFreeBlock(chunk);
+            tlabRetiredBytes += leftover;
+        } else if (leftover >= ThreadLocalAllocationBuffer::MIN_RETIRE_SIZE) {
+            arena.splitBlock(chunk, used, nextBlockId++);
+            tlabRetiredBytes += leftover;
+        } else {
+            tlabWasteBytes += leftover;
+        }
+        
+        // The objects in a retired TLAB are left to the collectors, which free the chunk as a
+        // whole, so the profiler stops counting them as in use here
+        for (const ObjectAllocation& allocation : tlab.getSampledObjects()) {
+            allocationProfiler->recordFree(allocation);
+        }
+        chunk->setPinned(false);
+        tlab.clear();
+    }
+    
+    // Reserve a chunk of the desired size, or at least one that fits this object
+    size_t desiredSize = std::max(tlab.getDesiredSize(), minSize);
+    std::shared_ptr<MemoryBlock> chunk = reserveBlock(arena, desiredSize, minSize);
+    if (!chunk) {
+        return false;
+    }
+    
+    tlab.reset(chunk, now);
+    tlabRefills++;
+    return true;
+}
+
+std::shared_ptr<MemoryBlock> MemoryManager::reserveBlock(MemoryArena& arena, size_t preferredSize, size_t minSize) {
+    std::shared_ptr<MemoryBlock> block;
+    
+    for (size_t wanted : {preferredSize, minSize}) {
+        while ((block = arena.takeFreeBlock(wanted))) {
+            // Claimed pinned, so no collector can free the block in between
+            if (arena.claimBlock(block, true)) {
+                break;
+            }
+        }
+        if (block) {
+            break;
+        }
+    }
+    
+    if (!block) {
+        return nullptr;
+    }
+    
+    trimBlock(arena, block, preferredSize);
+    return block;
+}
+
+void MemoryManager::trimBlock(MemoryArena& arena, const std::shared_ptr<MemoryBlock>& block, size_t size) {
+    // Trim an oversized block so the owner does not hold memory it will never use; a collection
+    // may have freed an unpinned block since it was claimed, and then there is nothing to trim
+    size = (size + ThreadLocalAllocationBuffer::ALIGNMENT - 1) & ~(ThreadLocalAllocationBuffer::ALIGNMENT - 1);
+    if (block->getStatus() == BlockStatus::ACTIVE &&
+        block->getSize() >= size + ThreadLocalAllocationBuffer::MIN_RETIRE_SIZE) {
+        arena.splitBlock(block, size, nextBlockId++);
+    }
+}
+
+HeapMapUpdate MemoryManager::getHeapMapLocked(HeapMap& heapMap, uint64_t sinceVersion) {
+    // Many clients polling at once share one render per refresh interval
+    auto now = std::chrono::steady_clock::now();
+    if (heapMap.getVersion() == 0 || now - heapMap.getLastRefresh() >= HEAP_MAP_REFRESH_INTERVAL) {
+        heapMap.refresh(renderHeapPixels(heapMap.getWidth()), now);
+    }
+    
+    return heapMap.getUpdate(sinceVersion);
+}
+
+std::vector<BlockStatus> MemoryManager::renderHeapPixels(uint32_t width) const {
+    // Bytes of each status falling into each pixel. Blocks are placed by their heap offset,
+    // since splits and merges leave the block tables out of address order.
+    std::vector<std::array<size_t, 3>> pixelBytes(width, std::array<size_t, 3>{{0, 0, 0}});
+    size_t total = std::max<size_t>(totalMemory, 1);
+    
+    auto addBytes = [&](size_t offset, size_t size, BlockStatus status) {
+        while (size > 0 && offset < total) {
+            size_t pixel = offset * width / total;
+            size_t pixelEnd = (pixel + 1) * total / width;
+            size_t bytes = std::min(size, std::max<size_t>(pixelEnd - offset, 1));
+            
+            pixelBytes[pixel][static_cast<size_t>(status)] += bytes;
+            offset += bytes;
+            size -= bytes;
         }
+    };
+    
+    for (const auto& arena : arenas) {
+        std::lock_guard<std::mutex> lock(arena->getMutex());
+        
+        // Drawing the map must not force a lazily initialised region into existence
+        if (!arena->isMaterialized()) {
+            addBytes(arena->getRegionOffset(), arena->getRegionSize(), BlockStatus::FREE);
+            continue;
+        }
+        
+        for (const auto& block : arena->getBlocks()) {
+            addBytes(block->getOffset(), block->getSize(), block->getStatus());
+        }
+    }
+    
+    std::vector<BlockStatus> pixels(width);
+    for (uint32_t i = 0; i < width; ++i) {
+        const auto& bytes = pixelBytes[i];
+        size_t dominant = std::max_element(bytes.begin(), bytes.end()) - bytes.begin();
+        pixels[i] = static_cast<BlockStatus>(dominant);
     }
     
-    fragmentation = static_cast<float>(fragmentedSize) / totalMemory * 100.0f;
+    return pixels;
+}
+
+std::unique_ptr<SlabAllocator> MemoryManager::createSlabAllocator() {
+    return std::make_unique<SlabAllocator>(
+        [this](size_t size) { return acquireSlabBlock(size); },
+        [this](const std::shared_ptr<MemoryBlock>& block) { releaseSlabBlock(block); });
+}
+
+std::shared_ptr<MemoryBlock> MemoryManager::acquireSlabBlock(size_t size) {
+    MemoryArena& arena = *arenas[getThreadCache().getArenaIndex()];
+    auto lock = lockArena(arena);
+    return reserveBlock(arena, size, size);
+}
+
+void MemoryManager::releaseSlabBlock(const std::shared_ptr<MemoryBlock>& block) {
+    MemoryArena& arena = *arenas[block->getArenaId()];
+    auto lock = lockArena(arena);
+    
+    if (arena.releaseBlock(block)) {
+        arena.pushFreeBlock(block);
+    }
 }
 
 void MemoryManager::initializeAlgorithms() {
@@ -647,6 +2540,33 @@ void MemoryManager::initializeAlgorithms() {
     algorithms.push_back(std::make_shared<GenerationalAlgorithm>(2));
     algorithms.push_back(std::make_shared<ReferenceCountingAlgorithm>(3));
     algorithms.push_back(std::make_shared<ConcurrentGcAlgorithm>(4));
+    // Opt-in: reshapes the block tables, so it only runs once enabled from the dashboard
+    algorithms.push_back(std::make_shared<RegionEvacuationAlgorithm>(
+        5, [this]() { return nextBlockId++; },
+        [this](size_t from, size_t to, size_t size) {
+            // Simulated blocks have no contents; real ones are copied to their new place
+            if (backing) {
+                std::memcpy(backing->getAddress(to, size), backing->getAddress(from, size), size);
+            }
+        }));
+    
+    for (const auto& algorithm : algorithms) {
+        algorithm->setAllocationProfiler(allocationProfiler.get());
+    }
+}
+
+void MemoryManager::logTopAllocationSites() {
+    const size_t SITES_LOGGED = 5;
+    auto sites = allocationProfiler->getSiteStats();
+    if (sites.empty()) {
+        return;
+    }
+    
+    std::cout << "Memory threshold exceeded; largest sampled allocation sites:" << std::endl;
+    for (size_t i = 0; i < std::min(SITES_LOGGED, sites.size()); ++i) {
+        std::cout << "  " << sites[i].site << ": " << sites[i].liveBytes << " bytes live, "
+                  << static_cast<uint64_t>(sites[i].allocatedBytesPerSecond) << " bytes/s allocated" << std::endl;
+    }
 }
 
 void MemoryManager::startBackgroundGc() {
@@ -664,21 +2584,89 @@ void MemoryManager::stopBackgroundGc() {
 }
 
 void MemoryManager::backgroundGcThread() {
+    auto lastPressureGc = std::chrono::steady_clock::now() - PRESSURE_GC_MIN_SPACING;
     while (running) {
+        MemoryPressureLevel pressure = pressureLevel;
+        
         // Check if auto collection is enabled
         if (settings->isAutoCollection()) {
-            // Check if memory usage is above threshold
-            float memoryUsagePercent = static_cast<float>(usedMemory) / totalMemory * 100.0f;
+            // Check if memory usage is above threshold; pressure on the machine lowers the bar
+            float memoryUsagePercent = static_cast<float>(getUsedMemory()) / totalMemory * 100.0f;
+            float configuredThreshold = static_cast<float>(settings->getMemoryThreshold());
+            float threshold = configuredThreshold;
+            if (pressure == MemoryPressureLevel::MODERATE) {
+                threshold *= MODERATE_PRESSURE_THRESHOLD_SCALE;
+            } else if (pressure == MemoryPressureLevel::CRITICAL) {
+                threshold *= CRITICAL_PRESSURE_THRESHOLD_SCALE;
+            }
             
-            if (memoryUsagePercent > settings->getMemoryThreshold()) {
+            // Over the configured threshold always collects; between the lowered and the configured
+            // one, collections are spaced out so sustained pressure does not turn into back-to-back GCs
+            auto now = std::chrono::steady_clock::now();
+            bool overThreshold = memoryUsagePercent > configuredThreshold;
+            bool pressureDue = memoryUsagePercent > threshold && now - lastPressureGc >= PRESSURE_GC_MIN_SPACING;
+            if (overThreshold || pressureDue) {
+                if (overThreshold) {
+                    logTopAllocationSites();
+                } else {
+                    lastPressureGc = now;
+                }
+                
                 // Run garbage collection
                 runGarbageCollection();
             }
         }
         
-        // Wait for the next check
+        // Wait for the next check; under pressure check every PRESSURE_GC_INTERVAL, and wake early if it rises
+        std::chrono::milliseconds interval = std::chrono::minutes(settings->getTimeInterval());
+        if (pressure != MemoryPressureLevel::NONE) {
+            interval = PRESSURE_GC_INTERVAL;
+        }
         std::unique_lock<std::mutex> lock(memoryMutex);
-        gcCondition.wait_for(lock, std::chrono::minutes(settings->getTimeInterval()));
+        gcCondition.wait_for(lock, interval, [this, pressure]() { return !running || pressureLevel > pressure; });
+    }
+}
+
+void MemoryManager::startPressureMonitor(const MemoryPressurePaths& paths) {
+    {
+        std::lock_guard<std::mutex> lock(pressureMutex);
+        pressureMonitor = std::make_unique<MemoryPressureMonitor>(paths);
+    }
+    pressureMonitoring = true;
+    pressureThreadObj = std::thread(&MemoryManager::pressureMonitorThread, this);
+}
+
+void MemoryManager::stopPressureMonitor() {
+    pressureMonitoring = false;
+    pressureMonitor->interrupt();
+    
+    if (pressureThreadObj.joinable()) {
+        pressureThreadObj.join();
+    }
+}
+
+void MemoryManager::pressureMonitorThread() {
+    while (pressureMonitoring) {
+        MemoryPressureSample sample = pressureMonitor->sample();
+        MemoryPressureLevel previous = pressureLevel.exchange(sample.level);
+        
+        // Parsing smaps walks every mapping in the process, so scrapes read this copy instead
+        if (backing) {
+            HeapResidency residency = backing->readResidency();
+            std::lock_guard<std::mutex> lock(pressureMutex);
+            *heapResidency = residency;
+        }
+        if (sample.level > previous) {
+            // Passing through the lock keeps the wakeup from slipping in between the scheduler's
+            // check and its wait; notifying after it is released saves the woken thread from blocking on it
+            {
+                std::lock_guard<std::mutex> lock(memoryMutex);
+            }
+            gcCondition.notify_one();
+        }
+        
+        pressureMonitor->wait(sample.level == MemoryPressureLevel::NONE
+            ? MemoryPressureMonitor::IDLE_POLL_INTERVAL : MemoryPressureMonitor::PRESSURED_POLL_INTERVAL);
     }
 }
 
@@ -694,12 +2682,42 @@ void MemoryManager::handleWebSocketMessage(const std::string& message) {
     if (reader.parse(message, root)) {
         std::string command = root["command"].asString();
         
+        // GC commands only queue a job, so this thread never waits on a collection
         if (command == "runGc") {
-            runGarbageCollection();
+            submitGcJob(GcJobType::COLLECTION, root["priority"].asInt());
         } else if (command == "optimizeMemory") {
-            optimizeMemory();
+            submitGcJob(GcJobType::OPTIMIZATION, root["priority"].asInt());
         } else if (command == "defragmentMemory") {
-            defragmentMemory();
+            submitGcJob(GcJobType::DEFRAGMENTATION, root["priority"].asInt());
+        } else if (command == "cancelGcJob") {
+            cancelGcJob(root["jobId"].asUInt64());
+        } else if (command == "getHeapMap") {
+            HeapMapUpdate update = getHeapMap(root["width"].asUInt(), root["version"].asUInt64());
+            
+            // Runs are packed as status letter + length, e.g. "a12f3x1"
+            Json::Value ranges(Json::arrayValue);
+            for (const auto& range : update.ranges) {
+                std::string runs;
+                for (const auto& run : range.runs) {
+                    runs += run.status == BlockStatus::ACTIVE ? 'a' : run.status == BlockStatus::FREE ? 'f' : 'x';
+                    runs += std::to_string(run.length);
+                }
+                
+                Json::Value rangeValue;
+                rangeValue["start"] = range.start;
+                rangeValue["runs"] = runs;
+                ranges.append(rangeValue);
+            }
+            
+            Json::Value response;
+            response["type"] = "heapMap";
+            response["version"] = static_cast<Json::UInt64>(update.version);
+            response["width"] = update.width;
+            response["full"] = update.full;
+            response["ranges"] = ranges;
+            
+            Json::FastWriter writer;
+            sendWebSocketMessage(writer.write(response));
         } else if (command == "updateSettings") {
             // Parse settings
             bool autoCollection = root["settings"]["autoCollection"].asBool();
@@ -738,4 +2756,52 @@ void MemoryManager::sendWebSocketMessage(const std::string& message) {
     // In a real implementation, this would send a WebSocket message
     // For simulation, we'll just print the message
     std::cout << "Sending WebSocket message: " << message << std::endl;
-} 
\ No newline at end of file
+} 
+
+void MemoryManager::sendGcJobEvent(const GcJobEvent& event) {
+    static const char* const operations[] = {"collection", "optimization", "defragmentation"};
+    static const char* const states[] = {"queued", "running", "completed", "cancelled"};
+    
+    Json::Value response;
+    response["type"] = "gcJob";
+    response["jobId"] = static_cast<Json::UInt64>(event.jobId);
+    response["operation"] = operations[static_cast<size_t>(event.type)];
+    response["state"] = states[static_cast<size_t>(event.state)];
+    response["progress"] = event.progress;
+    response["memoryReclaimed"] = static_cast<Json::UInt64>(event.memoryReclaimed);
+    response["requests"] = event.requests;
+    
+    Json::FastWriter writer;
+    sendWebSocketMessage(writer.write(response));
+}
+
+void MemoryManager::handleHttpRequest(const std::string& method, const std::string& path) {
+    // Plain HTTP requests arrive on the same event loop as WebSocket upgrades
+    if (method != "GET") {
+        sendHttpResponse(405, "text/plain", "Method Not Allowed\n");
+        return;
+    }
+    
+    if (path == "/metrics") {
+        // Only metricsMutex is held here, so scrapes never contend with collection on memoryMutex
+        std::lock_guard<std::mutex> lock(metricsMutex);
+        MetricsExporter exporter(*this);
+        exporter.render(metricsBuffer);
+        sendHttpResponse(200, MetricsExporter::CONTENT_TYPE, metricsBuffer);
+        return;
+    }
+    
+    if (path == "/debug/pprof/heap") {
+        sendHttpResponse(200, "application/octet-stream", allocationProfiler->exportPprof());
+        return;
+    }
+    
+    sendHttpResponse(404, "text/plain", "Not Found\n");
+}
+
+void MemoryManager::sendHttpResponse(int status, const char* contentType, const std::string& body) {
+    // In a real implementation, this would write the response to the HTTP connection
+    // For simulation, we'll just print a summary
+    std::cout << "Sending HTTP response: " << status << " " << contentType
+              << " (" << body.size() << " bytes)" << std::endl;
+}
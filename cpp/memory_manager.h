@@ -12,6 +12,9 @@
 #include <atomic>
 #include <condition_variable>
 #include <queue>
+#include <future>
+#include <array>
+#include <cstdint>
 
 // Forward declarations
 class GarbageCollector;
@@ -20,6 +23,26 @@ class GcAlgorithm;
 class GcActivity;
 class MemoryRecord;
 class GcSettings;
+class MemoryArena;
+class ThreadAllocationCache;
+class SlabAllocator;
+class HeapMap;
+struct HeapMapUpdate;
+class GcJobQueue;
+class FleetPublisher;
+class WeakBlockReference;
+class ReferenceProcessor;
+class FinalizationQueue;
+struct PendingFinalization;
+class HeapBacking;
+class AllocationProfiler;
+struct HeapResidency;
+class MemoryPressureMonitor;
+struct MemoryPressurePaths;
+struct MemoryPressureSample;
+enum class MemoryPressureLevel : int;
+enum class GcJobType;
+struct GcJobEvent;
 
 // Memory block status
 enum class BlockStatus {
@@ -35,27 +58,109 @@ enum class CollectionPriority {
     MEMORY
 };
 
+// Keeps the frames between an allocation call and the profiler's stack capture out of line at
+// every optimisation level, so captured stacks can drop a fixed number of them
+#if defined(__GNUC__)
+#define ALLOCATION_PROFILER_NOINLINE __attribute__((noinline))
+#else
+#define ALLOCATION_PROFILER_NOINLINE
+#endif
+
+// Called before each step of a long operation with the fraction already done; returning false stops it there
+using GcProgressCallback = std::function<bool(float)>;
+
+// Runs on the finalization thread once a collection finds the block dead, before its memory is reused
+using BlockFinalizer = std::function<void(const MemoryBlock&)>;
+
 // Memory block class
 class MemoryBlock {
 public:
-    MemoryBlock(int id, size_t size, BlockStatus status);
+    // Reference flags: set while the reference processor holds state for the block
+    static constexpr uint8_t WEAKLY_REFERENCED = 1;
+    static constexpr uint8_t FINALIZABLE = 2;
+    static constexpr uint8_t FINALIZING = 4; // Found dead, waiting for its finalizer to run
+    
+    MemoryBlock(int id, size_t size, BlockStatus status, int arenaId = 0, size_t offset = 0);
     
     int getId() const;
     size_t getSize() const;
     BlockStatus getStatus() const;
+    int getArenaId() const;
+    // Byte offset of the block in the heap; in real-memory mode, its offset into the reservation
+    size_t getOffset() const;
+    // Pinned blocks back allocator-owned chunks (TLABs, slabs) and are skipped by collectors.
+    // The pin lives in the status word, so it is set and cleared by the same CAS as the status.
+    bool isPinned() const;
+    // Set once the block has been handed out, cleared when its pages go back to the OS
+    bool isResident() const;
+    // Sampled by the allocation profiler and not yet freed
+    bool isSampled() const;
+    uint8_t getReferenceFlags() const;
     
+    // Also unpins; only for blocks no other thread can reach
     void setStatus(BlockStatus status);
+    void setSize(size_t size);
+    // Only an active block can be pinned; false if the block is not active
+    bool setPinned(bool pinned);
+    void setResident(bool resident);
+    // Moves the block; only region evacuation does this, under the arena lock, once the data is copied
+    void setOffset(size_t offset);
+    // Sample record from the allocation profiler
+    void setSample(uint32_t sample);
+    // Clears the sample; 0 if the block was not sampled or another thread took it first
+    uint32_t takeSample();
+    void addReferenceFlags(uint8_t flags);
+    void clearReferenceFlags();
+    
+    // Atomically moves an unpinned block from expected to desired; false if another thread
+    // got there first or the block is pinned
+    bool compareAndSetStatus(BlockStatus expected, BlockStatus desired);
+    // FREE to ACTIVE, pinned in the same step if pin is set
+    bool claim(bool pin);
+    // ACTIVE to FREE whether pinned or not, clearing the pin in the same step
+    bool release();
     
 private:
+    static constexpr uint8_t STATUS_MASK = 3;
+    static constexpr uint8_t PINNED = 4;
+    
     int id;
-    size_t size;
-    BlockStatus status;
+    std::atomic<size_t> size;
+    std::atomic<uint8_t> state; // BlockStatus in the low bits, PINNED above them
+    int arenaId;
+    std::atomic<size_t> offset;
+    std::atomic<bool> resident;
+    std::atomic<uint32_t> sample;
+    std::atomic<uint8_t> referenceFlags;
+};
+
+// Sweep random class
+// xorshift64* generator for simulated liveness decisions. Each algorithm seeds
+// one from std::random_device once instead of on every collection.
+class SweepRandom {
+public:
+    explicit SweepRandom(uint64_t seed);
+    
+    uint64_t next();
+    
+private:
+    uint64_t state;
 };
 
+// Sweep kernel: one collection pass specialised at compile time for an algorithm
+// and a CollectionPriority (see gc_kernels.h)
+// Reclaimed blocks that were sampled are reported to the profiler, when there is one.
+// Dead blocks with reference flags are left active and appended to discovered instead.
+using SweepKernel = size_t (*)(std::vector<std::shared_ptr<MemoryBlock>>& blocks, SweepRandom& random,
+                               AllocationProfiler* profiler, std::vector<std::shared_ptr<MemoryBlock>>& discovered);
+// Indexed by CollectionPriority
+using SweepKernels = std::array<SweepKernel, 3>;
+
 // GC Algorithm class
 class GcAlgorithm {
 public:
-    GcAlgorithm(int id, const std::string& name, const std::string& description, bool enabled, int performanceScore);
+    GcAlgorithm(int id, const std::string& name, const std::string& description, bool enabled, int performanceScore,
+                const SweepKernels& kernels);
     
     int getId() const;
     std::string getName() const;
@@ -65,9 +170,17 @@ public:
     
     void setEnabled(bool enabled);
     void setPerformanceScore(int score);
+    // Selects the kernel later collections run; caller holds the collection lock
+    void setCollectionPriority(CollectionPriority priority);
+    void setAllocationProfiler(AllocationProfiler* profiler);
     
-    // Virtual method for algorithm-specific collection
-    virtual size_t collect(std::vector<std::shared_ptr<MemoryBlock>>& blocks) = 0;
+    // Runs the kernel for the current priority; one indirect call per pass, none per block
+    virtual size_t collect(std::vector<std::shared_ptr<MemoryBlock>>& blocks);
+    // Collects one arena, caller holds its mutex. The default runs collect() over
+    // the block table; algorithms that reshape the table override it.
+    virtual size_t collectArena(MemoryArena& arena);
+    // Dead blocks the collections since the last call left for reference processing; caller holds the collection lock
+    std::vector<std::shared_ptr<MemoryBlock>>& getDiscoveredBlocks();
     
 protected:
     int id;
@@ -75,41 +188,93 @@ protected:
     std::string description;
     bool enabled;
     int performanceScore;
+    SweepKernels kernels;
+    SweepKernel kernel;
+    SweepRandom sweepRandom;
+    AllocationProfiler* allocationProfiler;
+    std::vector<std::shared_ptr<MemoryBlock>> discoveredBlocks;
 };
 
 // Mark-Sweep algorithm
 class MarkSweepAlgorithm : public GcAlgorithm {
 public:
     MarkSweepAlgorithm(int id);
-    size_t collect(std::vector<std::shared_ptr<MemoryBlock>>& blocks) override;
 };
 
 // Generational algorithm
 class GenerationalAlgorithm : public GcAlgorithm {
 public:
     GenerationalAlgorithm(int id);
-    size_t collect(std::vector<std::shared_ptr<MemoryBlock>>& blocks) override;
 };
 
 // Reference Counting algorithm
 class ReferenceCountingAlgorithm : public GcAlgorithm {
 public:
     ReferenceCountingAlgorithm(int id);
-    size_t collect(std::vector<std::shared_ptr<MemoryBlock>>& blocks) override;
 };
 
 // Concurrent GC algorithm
 class ConcurrentGcAlgorithm : public GcAlgorithm {
 public:
     ConcurrentGcAlgorithm(int id);
-    size_t collect(std::vector<std::shared_ptr<MemoryBlock>>& blocks) override;
+};
+
+// Region evacuation algorithm
+// Splits each arena into fixed-size address regions, tracks live bytes per
+// region and evacuates the most garbage-rich regions, as many as fit in the
+// pause target. Live blocks are copied into wholly free regions and take new
+// offsets there; the space they leave and the region's garbage become free
+// blocks, one per address run, so every collection also compacts part of the
+// heap. Pinned and reference-tracked blocks never move, and a region holding
+// one is not evacuated.
+class RegionEvacuationAlgorithm : public GcAlgorithm {
+public:
+    static constexpr size_t REGION_SIZE = 4 * 1024 * 1024;
+    static constexpr double MIN_GARBAGE_RATIO = 0.25; // Emptier regions are not worth copying
+    static constexpr int DEFAULT_PAUSE_TARGET_MS = 10;
+    
+    // moveMemory(from, to, size) copies a relocated block's contents between heap offsets
+    RegionEvacuationAlgorithm(int id, std::function<int()> nextBlockId,
+                              std::function<void(size_t, size_t, size_t)> moveMemory);
+    size_t collectArena(MemoryArena& arena) override;
+    
+    int getPauseTargetMs() const;
+    void setPauseTargetMs(int pauseTargetMs);
+    // Stats from the most recent evacuation
+    size_t getLastRegionsEvacuated() const;
+    double getLastPredictedPauseMs() const;
+    double getLastEvacuationPauseMs() const;
+    
+private:
+    struct Region {
+        size_t first;
+        size_t last;
+        size_t bytes;
+        size_t liveBytes;
+        double garbageRatio;
+        bool free;   // Every block free, so the whole region can take evacuated data
+        bool pinned; // Holds a block that must not move
+    };
+    
+    std::vector<Region> buildRegions(const std::vector<std::shared_ptr<MemoryBlock>>& blocks) const;
+    
+    std::function<int()> nextBlockId;
+    std::function<void(size_t, size_t, size_t)> moveMemory;
+    std::atomic<int> pauseTargetMs;
+    // Evacuation cost per block, learned from past collections and used to predict pauses
+    double nanosPerBlock;
+    std::atomic<size_t> lastRegionsEvacuated;
+    std::atomic<double> lastPredictedPauseMs;
+    std::atomic<double> lastEvacuationPauseMs;
 };
 
 // GC Activity class
 class GcActivity {
 public:
     GcActivity(int id, int algorithmId, const std::chrono::system_clock::time_point& timestamp,
-               int durationMs, size_t memoryReclaimed, int objectsCollected, float cpuImpact);
+               int durationMs, size_t memoryReclaimed, int objectsCollected, float cpuImpact,
+               std::chrono::microseconds pauseTime = std::chrono::microseconds(0),
+               std::chrono::microseconds referenceProcessingTime = std::chrono::microseconds(0));
     
     int getId() const;
     int getAlgorithmId() const;
@@ -118,6 +283,10 @@ public:
     size_t getMemoryReclaimed() const;
     int getObjectsCollected() const;
     float getCpuImpact() const;
+    // Time arenas spent locked for sweeping, and for clearing weak references and queueing finalizers;
+    // the duration also covers what runs between arenas
+    std::chrono::microseconds getPauseTime() const;
+    std::chrono::microseconds getReferenceProcessingTime() const;
     
 private:
     int id;
@@ -127,6 +296,207 @@ private:
     size_t memoryReclaimed;
     int objectsCollected;
     float cpuImpact;
+    std::chrono::microseconds pauseTime;
+    std::chrono::microseconds referenceProcessingTime;
+};
+
+// Pause histogram class
+// Lock-free fixed-bucket histogram of pause durations, safe to read while
+// collections are recording into it.
+class PauseHistogram {
+public:
+    static constexpr size_t BUCKET_COUNT = 12;
+    static const std::array<double, BUCKET_COUNT> BUCKET_BOUNDS_SECONDS;
+    
+    PauseHistogram();
+    
+    void record(std::chrono::microseconds pause);
+    
+    // Cumulative count of observations <= BUCKET_BOUNDS_SECONDS[index]
+    uint64_t getCumulativeCount(size_t index) const;
+    uint64_t getCount() const;
+    double getSumSeconds() const;
+    
+private:
+    std::array<std::atomic<uint64_t>, BUCKET_COUNT> buckets;
+    std::atomic<uint64_t> count;
+    std::atomic<uint64_t> sumMicros;
+};
+
+// Pause type
+enum class PauseType {
+    COLLECTION,
+    OPTIMIZATION,
+    DEFRAGMENTATION
+};
+
+// Memory Arena class
+// One shard of the heap with its own block table, free list and lock. Usage
+// counters are atomic so aggregate stats can be summed without any lock.
+class MemoryArena {
+public:
+    explicit MemoryArena(int id);
+    
+    int getId() const;
+    size_t getTotalMemory() const;
+    size_t getUsedMemory() const;
+    size_t getFreeMemory() const;
+    size_t getFragmentedMemory() const;
+    
+    // Regions are generated lazily or in parallel; until then the arena holds no blocks
+    bool isMaterialized() const;
+    size_t getRegionOffset() const;
+    size_t getRegionSize() const;
+    uint32_t getRegionSeed() const;
+    void setPendingRegion(size_t regionOffset, size_t regionSize, uint32_t regionSeed);
+    void markMaterialized();
+    
+    // Guards the block table and free list
+    std::mutex& getMutex() const;
+    std::vector<std::shared_ptr<MemoryBlock>>& getBlocks();
+    const std::vector<std::shared_ptr<MemoryBlock>>& getBlocks() const;
+    
+    // Block table operations, caller holds the arena mutex
+    void reserveBlocks(size_t count);
+    void addBlock(const std::shared_ptr<MemoryBlock>& block);
+    std::shared_ptr<MemoryBlock> takeFreeBlock(size_t minSize);
+    void pushFreeBlock(const std::shared_ptr<MemoryBlock>& block);
+    void rebuildFreeList();
+    // Retires and drops every block and zeroes the counters, ready for a restore
+    void clear();
+    // Shrinks an active block to keepSize and adds the tail as a new free block
+    std::shared_ptr<MemoryBlock> splitBlock(const std::shared_ptr<MemoryBlock>& block, size_t keepSize, int tailId);
+    
+    // Lock-free status transitions that keep the usage counters in step
+    bool claimBlock(const std::shared_ptr<MemoryBlock>& block, bool pin = false);
+    bool releaseBlock(const std::shared_ptr<MemoryBlock>& block);
+    bool reclaimFragmentedBlock(const std::shared_ptr<MemoryBlock>& block);
+    void accountCollected(size_t memoryReclaimed);
+    // Takes a free block out of circulation ahead of dropping it from the table;
+    // false if a mutator claimed it first
+    bool retireFreeBlock(const std::shared_ptr<MemoryBlock>& block);
+    // Installs a rebuilt block table holding addedFreeBytes of new free blocks.
+    // Caller holds the arena mutex and rebuilds the free list afterwards.
+    void replaceBlocks(std::vector<std::shared_ptr<MemoryBlock>> newBlocks, size_t addedFreeBytes);
+    
+private:
+    int id;
+    std::vector<std::shared_ptr<MemoryBlock>> blocks;
+    // May hold stale entries that were claimed elsewhere; claimBlock() filters them out
+    std::vector<std::shared_ptr<MemoryBlock>> freeList;
+    mutable std::mutex mutex;
+    
+    std::atomic<bool> materialized;
+    size_t regionOffset;
+    size_t regionSize;
+    uint32_t regionSeed;
+    
+    std::atomic<size_t> totalMemory;
+    std::atomic<size_t> usedMemory;
+    std::atomic<size_t> freeMemory;
+    std::atomic<size_t> fragmentedMemory;
+};
+
+// Object allocation
+// A small object carved out of a block by a TLAB or a slab.
+struct ObjectAllocation {
+    int blockId;
+    uint32_t sample; // Allocation profiler record, 0 unless sampled; sits in what was padding
+    size_t offset;
+    size_t size;
+};
+
+// Thread Local Allocation Buffer class
+// A chunk of the heap reserved by one mutator thread and bump-allocated
+// without locks or atomics. Its size follows the thread's allocation rate.
+class ThreadLocalAllocationBuffer {
+public:
+    static constexpr size_t ALIGNMENT = 8;
+    static constexpr size_t MIN_SIZE = 4 * 1024;
+    static constexpr size_t MAX_SIZE = 1024 * 1024;
+    static constexpr size_t MAX_OBJECT_SIZE = 2 * 1024; // Larger objects go through allocateMemory()
+    static constexpr size_t MIN_RETIRE_SIZE = 1024; // Smaller leftovers are counted as waste
+    
+    ThreadLocalAllocationBuffer();
+    
+    bool tryAllocate(size_t size, ObjectAllocation& allocation);
+    
+    void reset(const std::shared_ptr<MemoryBlock>& chunk, std::chrono::steady_clock::time_point now);
+    void clear();
+    
+    // Retunes the next chunk size so the thread refills roughly every REFILL_INTERVAL
+    void updateDesiredSize(std::chrono::steady_clock::time_point now);
+    
+    std::shared_ptr<MemoryBlock> getChunk() const;
+    size_t getUsed() const;
+    size_t getRemaining() const;
+    size_t getDesiredSize() const;
+    
+    // Bytes left until the next profiler sample. The fast path stops there, so only the
+    // allocation that reaches it takes the slow path; the chunk end still applies.
+    int64_t getSampleDistance() const;
+    void setSampleDistance(int64_t distance);
+    // Charges the bytes bump-allocated since the last slow path, plus size, to the sample
+    // distance and lifts the limit to the chunk end; true when a sample is due
+    bool consumeSampleBytes(size_t size);
+    // Sampled objects in the current chunk; their samples are charged back when the chunk is retired
+    void addSampledObject(const ObjectAllocation& allocation);
+    const std::vector<ObjectAllocation>& getSampledObjects() const;
+    
+private:
+    static constexpr std::chrono::milliseconds REFILL_INTERVAL{5};
+    
+    std::shared_ptr<MemoryBlock> chunk;
+    int chunkId;
+    size_t top;
+    size_t limit; // min(end, next sample point)
+    size_t end;
+    size_t countedTop; // top when the sample distance was last charged
+    int64_t sampleDistance;
+    size_t desiredSize;
+    double allocationRate; // Bytes per second, exponentially smoothed
+    std::chrono::steady_clock::time_point startTime;
+    std::vector<ObjectAllocation> sampledObjects;
+};
+
+// Thread Allocation Cache class
+// Free blocks a mutator thread has claimed in bulk from its arena, so most
+// allocations and frees complete without taking any lock. Only the owning
+// thread touches it; once that thread exits or moves to another manager, the
+// cache passes, contents and all, to the next thread that binds.
+class ThreadAllocationCache {
+public:
+    static constexpr size_t CAPACITY = 64;
+    static constexpr size_t REFILL_BATCH = 16;
+    
+    explicit ThreadAllocationCache(size_t arenaIndex);
+    
+    // Ownership handoff between threads; tryAcquire() is false while another thread owns the cache
+    bool tryAcquire();
+    void release();
+    
+    // The manager's cache epoch when the cache was last emptied; a restore moves the epoch on
+    uint64_t getEpoch() const;
+    // Drops the cached blocks and the TLAB, which belonged to a replaced block heap; owner only
+    void invalidate(uint64_t epoch);
+    
+    size_t getArenaIndex() const;
+    std::vector<std::shared_ptr<MemoryBlock>>& getBlocks();
+    ThreadLocalAllocationBuffer& getTlab();
+    
+    // Counts allocated bytes towards the next profiler sample; true when it is due
+    bool consumeSampleBytes(size_t size);
+    void setBytesUntilSample(int64_t bytes);
+    SweepRandom& getSampleRandom();
+    
+private:
+    std::atomic<bool> owned;
+    uint64_t epoch;
+    size_t arenaIndex;
+    std::vector<std::shared_ptr<MemoryBlock>> blocks;
+    ThreadLocalAllocationBuffer tlab;
+    int64_t bytesUntilSample;
+    SweepRandom sampleRandom;
 };
 
 // Memory Record class
@@ -183,7 +553,13 @@ private:
 // Memory Manager class
 class MemoryManager {
 public:
-    MemoryManager();
+    static constexpr size_t DEFAULT_HEAP_SIZE = 10ULL * 1024 * 1024 * 1024; // 10 GB
+    
+    // arenaCount of 0 uses one arena per hardware thread. With lazyInitialization each
+    // arena's blocks are generated on first touch instead of before the constructor returns.
+    // With realMemory the heap is backed by one mmap reservation instead of being simulated
+    explicit MemoryManager(size_t arenaCount = 0, size_t heapSize = DEFAULT_HEAP_SIZE,
+                           bool lazyInitialization = false, bool realMemory = false);
     ~MemoryManager();
     
     // Memory operations
@@ -192,10 +568,66 @@ public:
     size_t getFreeMemory() const;
     float getFragmentation() const;
     
+    // Allocation operations, safe to call from any number of mutator threads.
+    // With real memory, allocated blocks stay pinned until freeMemory() so collections never reclaim them.
+    // site is a tag from registerAllocationSite(), used when the allocation is sampled.
+    std::shared_ptr<MemoryBlock> allocateMemory(size_t size, uint32_t site = 0);
+    void freeMemory(const std::shared_ptr<MemoryBlock>& block);
+    // Bump-allocates a small object from the calling thread's TLAB; false if too large or out of memory
+    bool allocateObject(size_t size, ObjectAllocation& allocation, uint32_t site = 0);
+    // Size-class allocation for small objects that are freed individually
+    bool allocateSlabObject(size_t size, ObjectAllocation& allocation, uint32_t site = 0);
+    bool freeSlabObject(const ObjectAllocation& allocation);
+    
+    // Reference operations
+    // Hands an allocated block to the collector instead of freeing it, so it lives until a collection
+    // finds it dead; in real-memory mode this unpins it. Simulated blocks are always collectable.
+    void releaseToCollector(const std::shared_ptr<MemoryBlock>& block);
+    // A weak reference does not keep its block alive; it is cleared when a collection finds the block dead
+    std::shared_ptr<WeakBlockReference> createWeakReference(const std::shared_ptr<MemoryBlock>& block);
+    // The referent, held again as if just allocated; nullptr once the reference is cleared
+    std::shared_ptr<MemoryBlock> getWeakReferent(const WeakBlockReference& reference);
+    // Replaces any earlier finalizer; the block is freed once the finalizer has run. False if the block is not allocated.
+    bool registerFinalizer(const std::shared_ptr<MemoryBlock>& block, BlockFinalizer finalizer);
+    // Waits until every finalizer queued so far has run
+    void runFinalization();
+    size_t getPendingFinalizations() const;
+    uint64_t getFinalizedBlocks() const;
+    uint64_t getClearedWeakReferences() const;
+    
+    // Allocation profiling
+    uint32_t registerAllocationSite(const std::string& name);
+    AllocationProfiler& getAllocationProfiler();
+    
+    // Arena operations
+    size_t getArenaCount() const;
+    const MemoryArena& getArena(size_t index) const;
+    
+    // Real-memory operations
+    bool isMemoryBacked() const;
+    // Start of the block's memory; nullptr when the heap is simulated
+    void* getBlockAddress(const MemoryBlock& block) const;
+    // Kernel's view of the reservation from /proc/self/smaps, to cross-check the usage counters.
+    // Read on the pressure monitor thread at every poll, so this only copies the latest reading.
+    HeapResidency getHeapResidency() const;
+    size_t getReleasedMemoryTotal() const;
+    
+    // Memory pressure operations
+    // Points the monitor at other PSI and cgroup files, such as stand-ins in tests, and restarts it
+    void setMemoryPressurePaths(const MemoryPressurePaths& paths);
+    MemoryPressureSample getMemoryPressure() const;
+    MemoryPressureLevel getMemoryPressureLevel() const;
+    
     // GC operations
-    size_t runGarbageCollection();
-    size_t optimizeMemory();
-    size_t defragmentMemory();
+    size_t runGarbageCollection(const GcProgressCallback& progress = nullptr);
+    size_t runArenaCollection(size_t arenaIndex);
+    size_t optimizeMemory(const GcProgressCallback& progress = nullptr);
+    size_t defragmentMemory(const GcProgressCallback& progress = nullptr);
+    
+    // GC job operations
+    // Queues a GC operation for the worker pool; job events go out over the WebSocket
+    uint64_t submitGcJob(GcJobType type, int priority = 0);
+    bool cancelGcJob(uint64_t jobId);
     
     // Algorithm operations
     std::vector<std::shared_ptr<GcAlgorithm>> getAllAlgorithms() const;
@@ -209,17 +641,47 @@ public:
     std::vector<std::shared_ptr<MemoryRecord>> getRecentMemoryRecords(int limit = 100) const;
     
     // Memory block operations
+    // Copies every block handle; prefer getHeapMap() for rendering
     std::vector<std::shared_ptr<MemoryBlock>> getAllBlocks() const;
     
+    // Heap map operations
+    static constexpr uint32_t MAX_HEAP_MAP_WIDTH = 4096;
+    static constexpr size_t MAX_HEAP_MAPS = 16; // Widths cached at once
+    static constexpr std::chrono::milliseconds HEAP_MAP_REFRESH_INTERVAL{100};
+    // Run-length-encoded heap picture, width pixels wide, as a diff since sinceVersion when possible
+    HeapMapUpdate getHeapMap(uint32_t width, uint64_t sinceVersion = 0);
+    
     // Settings operations
     std::shared_ptr<GcSettings> getSettings() const;
     bool updateSettings(const GcSettings& settings);
     
+    // Snapshot operations
+    // Copies the heap state arena by arena and writes it on a background thread
+    std::future<bool> saveSnapshot(const std::string& path) const;
+    // Replaces the heap state from a snapshot file; call before mutator threads start.
+    // Queued finalizers run first, without memoryMutex held, so they may allocate and collect.
+    // False if the file is invalid or its blocks do not fit this manager's heap.
+    bool restoreSnapshot(const std::string& path);
+    
     // Stats operations
     int getGcRunsToday() const;
     std::chrono::system_clock::time_point getLastGcRun() const;
     int getAverageGcDuration() const;
     float getCpuImpact() const;
+    size_t getMemoryReclaimedTotal() const;
+    const PauseHistogram& getPauseHistogram(PauseType type) const;
+    uint64_t getTlabRefills() const;
+    size_t getTlabAllocatedBytes() const;
+    size_t getTlabRetiredBytes() const;
+    size_t getTlabWasteBytes() const;
+    size_t getSlabMemory() const;
+    float getSlabOccupancy() const;
+    size_t getSlabInternalFragmentation() const;
+    
+    // Fleet operations
+    // Streams stats and activities to the fleet aggregator listening on socketPath; false if already publishing
+    bool startFleetPublisher(const std::string& socketPath, const std::string& name);
+    void stopFleetPublisher();
     
     // WebSocket interface
     void startWebSocketServer(int port = 8080);
@@ -227,46 +689,154 @@ public:
     
 private:
     // Memory management
-    void initializeMemory(size_t totalMemory = 10 * 1024 * 1024 * 1024); // 10 GB default
-    void allocateMemory(size_t size);
-    void freeMemory(size_t size);
+    void initializeMemory(size_t totalMemory, bool lazyInitialization);
+    void materializeArenas();
+    // Generates the arena's region if it has not been yet; caller holds the arena mutex
+    void materializeArena(MemoryArena& arena) const;
+    // Locks an arena, materialising it on first touch
+    std::unique_lock<std::mutex> lockArena(MemoryArena& arena) const;
     void updateMemoryUsage();
-    void updateFragmentation();
+    ThreadAllocationCache& getThreadCache();
+    ThreadAllocationCache& bindThreadCache();
+    bool refillThreadCache(ThreadAllocationCache& cache, size_t minSize);
+    bool refillTlab(ThreadAllocationCache& cache, size_t minSize);
+    // Samples a block or object whose thread's byte countdown ran out; returns the distance to the next sample
+    template <typename Allocation>
+    ALLOCATION_PROFILER_NOINLINE int64_t sampleAllocation(ThreadAllocationCache& cache, Allocation& allocation, uint32_t site);
+    // Claims and pins a free block of at least minSize, trimmed to preferredSize; caller holds the arena mutex
+    std::shared_ptr<MemoryBlock> reserveBlock(MemoryArena& arena, size_t preferredSize, size_t minSize);
+    // Splits the unneeded tail off a claimed block and frees it; caller holds the arena mutex
+    void trimBlock(MemoryArena& arena, const std::shared_ptr<MemoryBlock>& block, size_t size);
+    std::unique_ptr<SlabAllocator> createSlabAllocator();
+    // Caller holds heapMapsMutex
+    HeapMapUpdate getHeapMapLocked(HeapMap& heapMap, uint64_t sinceVersion);
+    std::vector<BlockStatus> renderHeapPixels(uint32_t width) const;
+    std::shared_ptr<MemoryBlock> acquireSlabBlock(size_t size);
+    void releaseSlabBlock(const std::shared_ptr<MemoryBlock>& block);
+    size_t runCollection(size_t firstArena, size_t lastArena, const GcProgressCallback& progress);
+    size_t runGcJob(GcJobType type, const GcProgressCallback& progress);
+    // Returns the pages of free blocks to the OS in real-memory mode; caller holds the arena mutex
+    void releaseFreeRanges(MemoryArena& arena);
+    // Sorts the block table by offset and merges each run of adjacent free blocks into one;
+    // caller holds the arena mutex. Returns the bytes folded into a preceding free block
+    size_t mergeFreeBlocks(MemoryArena& arena);
+    // Reference-processing phase: clears the weak references of discovered blocks, frees them and moves
+    // finalizable ones to finalizations. Caller holds the arena mutex; returns the bytes freed
+    size_t processReferences(MemoryArena& arena, std::vector<std::shared_ptr<MemoryBlock>>& discovered,
+                             std::vector<PendingFinalization>& finalizations);
+    // Frees a block whose finalizer has run; called on the finalization thread
+    void releaseFinalizedBlock(const std::shared_ptr<MemoryBlock>& block);
+    void logTopAllocationSites();
     
     // GC management
     void initializeAlgorithms();
     void startBackgroundGc();
     void stopBackgroundGc();
     void backgroundGcThread();
+    void startPressureMonitor(const MemoryPressurePaths& paths);
+    void stopPressureMonitor();
+    void pressureMonitorThread();
     
     // WebSocket management
     void handleWebSocketMessage(const std::string& message);
     void sendWebSocketMessage(const std::string& message);
+    void sendGcJobEvent(const GcJobEvent& event);
+    
+    // HTTP endpoints served from the WebSocket server's event loop
+    void handleHttpRequest(const std::string& method, const std::string& path);
+    void sendHttpResponse(int status, const char* contentType, const std::string& body);
     
     // Data members
-    std::vector<std::shared_ptr<MemoryBlock>> memoryBlocks;
+    std::vector<std::unique_ptr<MemoryArena>> arenas;
     std::vector<std::shared_ptr<GcAlgorithm>> algorithms;
     std::vector<std::shared_ptr<GcActivity>> activities;
+    int nextActivityId; // Guarded by activitiesMutex; ids keep growing after old activities are dropped
     std::vector<std::shared_ptr<MemoryRecord>> memoryRecords;
     std::shared_ptr<GcSettings> settings;
     
-    size_t totalMemory;
-    size_t usedMemory;
-    size_t freeMemory;
-    float fragmentation;
+    // Stats are atomic so readers such as the metrics endpoint never need memoryMutex;
+    // used/free/fragmented bytes are summed from the arenas on demand
+    std::atomic<size_t> totalMemory;
+    // Heap size the manager was built with, and the size of the reservation in real-memory mode
+    const size_t heapCapacity;
     
-    int gcRunsToday;
-    std::chrono::system_clock::time_point lastGcRun;
-    int averageGcDuration;
-    float cpuImpact;
+    std::atomic<int> gcRunsToday;
+    std::atomic<std::chrono::system_clock::rep> lastGcRun;
+    std::atomic<int> averageGcDuration;
+    std::atomic<float> cpuImpact;
+    std::atomic<size_t> memoryReclaimedTotal;
+    std::array<PauseHistogram, 3> pauseHistograms;
     
     std::atomic<bool> running;
     std::thread backgroundGcThreadObj;
+    // Serialises collections and their stats; mutators only take arena locks
     std::mutex memoryMutex;
-    std::mutex activitiesMutex;
-    std::mutex recordsMutex;
+    mutable std::mutex activitiesMutex;
+    mutable std::mutex recordsMutex;
     std::condition_variable gcCondition;
     
+    // Machine-wide memory pressure, sampled on its own thread; a rise wakes the GC scheduler early
+    static constexpr std::chrono::seconds PRESSURE_GC_INTERVAL{1};
+    // Collections that only run because pressure lowered the threshold are at least this far apart
+    static constexpr std::chrono::seconds PRESSURE_GC_MIN_SPACING{10};
+    // Fraction of the memory threshold that still applies under moderate and critical pressure
+    static constexpr float MODERATE_PRESSURE_THRESHOLD_SCALE = 0.5f;
+    static constexpr float CRITICAL_PRESSURE_THRESHOLD_SCALE = 0.25f;
+    std::unique_ptr<MemoryPressureMonitor> pressureMonitor;
+    std::thread pressureThreadObj;
+    std::atomic<bool> pressureMonitoring;
+    std::atomic<MemoryPressureLevel> pressureLevel;
+    mutable std::mutex pressureMutex; // Guards replacing pressureMonitor and heapResidency
+    std::mutex pressureRestartMutex; // Serialises stopping and restarting the monitor thread; held across the join
+    
+    // Thread caches are shared with a thread_local slot tagged with instanceId, so a cache outlives
+    // its manager while a thread still points at it. There are never more than the peak number of
+    // threads that allocated at once: bindThreadCache() reuses the caches of threads that are gone.
+    // Caches are never destroyed while the manager lives; a restore moves cacheEpoch on instead,
+    // and each owner empties its cache the next time it uses it.
+    const uint64_t instanceId;
+    std::atomic<uint64_t> cacheEpoch;
+    std::mutex threadCachesMutex;
+    std::vector<std::shared_ptr<ThreadAllocationCache>> threadCaches;
+    std::atomic<size_t> nextArenaAssignment;
+    // Mutable because const readers can trigger lazy materialisation, which draws block ids
+    mutable std::atomic<int> nextBlockId;
+    
+    // TLAB stats, updated only when a TLAB is retired or refilled
+    std::atomic<uint64_t> tlabRefills;
+    std::atomic<size_t> tlabAllocatedBytes;
+    std::atomic<size_t> tlabRetiredBytes;
+    std::atomic<size_t> tlabWasteBytes;
+    
+    std::unique_ptr<SlabAllocator> slabAllocator;
+    
+    std::unique_ptr<AllocationProfiler> allocationProfiler;
+    
+    // Null unless the heap is backed by real memory
+    std::unique_ptr<HeapBacking> backing;
+    std::atomic<size_t> releasedMemoryTotal;
+    std::unique_ptr<HeapResidency> heapResidency; // Guarded by pressureMutex; null without backing
+    
+    // Control commands run here instead of on the WebSocket thread
+    std::unique_ptr<GcJobQueue> gcJobs;
+    
+    // Heap maps are cached per width and shared by every client asking for that width
+    std::mutex heapMapsMutex;
+    std::map<uint32_t, std::unique_ptr<HeapMap>> heapMaps;
+    uint64_t heapMapVersions; // Last version handed out by any heap map; guarded by heapMapsMutex
+    
+    // Weak references and finalizers; finalizers run on the queue's thread, never under memoryMutex
+    std::unique_ptr<ReferenceProcessor> referenceProcessor;
+    std::unique_ptr<FinalizationQueue> finalizationQueue;
+    std::vector<PendingFinalization> pendingFinalizations; // Guarded by memoryMutex; reused by every collection
+    
+    // Null until startFleetPublisher()
+    std::unique_ptr<FleetPublisher> fleetPublisher;
+    
+    // Metrics rendering reuses one buffer; scrapers serialise on metricsMutex only
+    std::mutex metricsMutex;
+    std::string metricsBuffer;
+    
     // WebSocket server
     void* wsServer; // Opaque pointer to WebSocket server implementation
 };
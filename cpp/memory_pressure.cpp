@@ -0,0 +1,262 @@
+#include "memory_pressure.h"
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+
+#if defined(__linux__)
+#define MEMORY_PRESSURE_USE_PSI 1
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/vfs.h>
+#include <unistd.h>
+#else
+#define MEMORY_PRESSURE_USE_PSI 0
+#include <thread>
+#endif
+
+namespace {
+
+#if MEMORY_PRESSURE_USE_PSI
+// Filesystem magics from linux/magic.h; triggers are only written to real kernel files
+constexpr long PROC_SUPER_MAGIC = 0x9fa0;
+constexpr long CGROUP2_SUPER_MAGIC = 0x63677270;
+#endif
+
+// Parses "avg10=1.23" out of a PSI line such as "some avg10=1.23 avg60=0.50 avg300=0.10 total=12345"
+double parseAvg10(const std::string& line) {
+    size_t position = line.find("avg10=");
+    if (position == std::string::npos) {
+        return 0.0;
+    }
+    return std::strtod(line.c_str() + position + 6, nullptr);
+}
+
+bool readNumber(const std::string& path, size_t& value, bool& unlimited) {
+    std::ifstream file(path);
+    std::string text;
+    if (!file || !(file >> text)) {
+        return false;
+    }
+    unlimited = text == "max";
+    value = unlimited ? 0 : std::strtoull(text.c_str(), nullptr, 10);
+    return true;
+}
+
+} // namespace
+
+// MemoryPressurePaths implementation
+MemoryPressurePaths MemoryPressurePaths::detect(const std::string& procRoot, const std::string& cgroupRoot) {
+    MemoryPressurePaths paths;
+    paths.psi = procRoot + "/pressure/memory";
+    
+    // cgroup v2 lists the process as "0::/path/of/cgroup"; v1 hierarchies use other ids and are skipped
+    std::ifstream cgroups(procRoot + "/self/cgroup");
+    std::string line;
+    while (std::getline(cgroups, line)) {
+        if (line.compare(0, 3, "0::") == 0) {
+            std::string directory = cgroupRoot + line.substr(3);
+            if (directory.back() != '/') {
+                directory += '/';
+            }
+            paths.cgroupEvents = directory + "memory.events";
+            paths.cgroupCurrent = directory + "memory.current";
+            paths.cgroupMax = directory + "memory.max";
+            break;
+        }
+    }
+    
+    return paths;
+}
+
+// MemoryPressureMonitor implementation
+MemoryPressureMonitor::MemoryPressureMonitor(const MemoryPressurePaths& paths)
+    : paths(paths), triggerFd(-1), wakeFds{-1, -1}, eventsSeen(false),
+      lastHighEvents(0), lastMaxEvents(0), lastOomEvents(0), eventLevel(MemoryPressureLevel::NONE),
+      lastSample{false, 0.0, 0.0, false, 0, 0, 0, 0, 0, MemoryPressureLevel::NONE} {
+#if MEMORY_PRESSURE_USE_PSI
+    if (pipe(wakeFds) == 0) {
+        fcntl(wakeFds[0], F_SETFL, O_NONBLOCK);
+        fcntl(wakeFds[1], F_SETFL, O_NONBLOCK);
+    } else {
+        wakeFds[0] = wakeFds[1] = -1;
+    }
+    
+    // Writing a trigger to a stand-in file would just overwrite it, so check where the path lives
+    struct statfs filesystem;
+    if (!paths.psi.empty() && statfs(paths.psi.c_str(), &filesystem) == 0 &&
+        (static_cast<long>(filesystem.f_type) == PROC_SUPER_MAGIC ||
+         static_cast<long>(filesystem.f_type) == CGROUP2_SUPER_MAGIC)) {
+        triggerFd = open(paths.psi.c_str(), O_RDWR | O_NONBLOCK | O_CLOEXEC);
+        if (triggerFd >= 0) {
+            // Kernels before 5.2, and containers that mount /proc read-only, refuse the trigger
+            std::string trigger = "some " + std::to_string(TRIGGER_STALL_US) + " " + std::to_string(TRIGGER_WINDOW_US);
+            if (write(triggerFd, trigger.c_str(), trigger.size() + 1) < 0) {
+                close(triggerFd);
+                triggerFd = -1;
+            }
+        }
+    }
+#endif
+}
+
+MemoryPressureMonitor::~MemoryPressureMonitor() {
+#if MEMORY_PRESSURE_USE_PSI
+    if (triggerFd >= 0) {
+        close(triggerFd);
+    }
+    if (wakeFds[0] >= 0) {
+        close(wakeFds[0]);
+        close(wakeFds[1]);
+    }
+#endif
+}
+
+const MemoryPressurePaths& MemoryPressureMonitor::getPaths() const {
+    return paths;
+}
+
+bool MemoryPressureMonitor::hasTrigger() const {
+    return triggerFd >= 0;
+}
+
+MemoryPressureSample MemoryPressureMonitor::sample() {
+    MemoryPressureSample sample{false, 0.0, 0.0, false, 0, 0, 0, 0, 0, MemoryPressureLevel::NONE};
+    sample.psiAvailable = readPsi(sample);
+    sample.cgroupAvailable = readCgroup(sample);
+    
+    double cgroupUsage = sample.cgroupMax > 0
+        ? static_cast<double>(sample.cgroupCurrent) / static_cast<double>(sample.cgroupMax) * 100.0 : 0.0;
+    
+    if (sample.fullAvg10 >= CRITICAL_FULL_AVG10 || cgroupUsage >= CRITICAL_CGROUP_USAGE) {
+        sample.level = MemoryPressureLevel::CRITICAL;
+    } else if (sample.someAvg10 >= MODERATE_SOME_AVG10 || cgroupUsage >= MODERATE_CGROUP_USAGE) {
+        sample.level = MemoryPressureLevel::MODERATE;
+    }
+    
+    // max and oom events mean the cgroup is already reclaiming hard or killing; high means it is throttled
+    auto now = std::chrono::steady_clock::now();
+    MemoryPressureLevel newEventLevel = sample.newMaxEvents > 0 || sample.newOomEvents > 0 ? MemoryPressureLevel::CRITICAL
+        : sample.newHighEvents > 0 ? MemoryPressureLevel::MODERATE : MemoryPressureLevel::NONE;
+    if (newEventLevel != MemoryPressureLevel::NONE) {
+        eventLevel = now < eventHoldUntil ? std::max(eventLevel, newEventLevel) : newEventLevel;
+        eventHoldUntil = now + EVENT_HOLD;
+    }
+    if (now < eventHoldUntil) {
+        sample.level = std::max(sample.level, eventLevel);
+    }
+    
+    std::lock_guard<std::mutex> lock(lastSampleMutex);
+    lastSample = sample;
+    return sample;
+}
+
+MemoryPressureSample MemoryPressureMonitor::getLastSample() const {
+    std::lock_guard<std::mutex> lock(lastSampleMutex);
+    return lastSample;
+}
+
+bool MemoryPressureMonitor::readPsi(MemoryPressureSample& sample) const {
+    if (paths.psi.empty()) {
+        return false;
+    }
+    
+    std::ifstream psi(paths.psi);
+    if (!psi) {
+        return false;
+    }
+    
+    bool found = false;
+    std::string line;
+    while (std::getline(psi, line)) {
+        if (line.compare(0, 5, "some ") == 0) {
+            sample.someAvg10 = parseAvg10(line);
+            found = true;
+        } else if (line.compare(0, 5, "full ") == 0) {
+            sample.fullAvg10 = parseAvg10(line);
+            found = true;
+        }
+    }
+    return found;
+}
+
+bool MemoryPressureMonitor::readCgroup(MemoryPressureSample& sample) {
+    bool unlimited = false;
+    bool found = !paths.cgroupCurrent.empty() && readNumber(paths.cgroupCurrent, sample.cgroupCurrent, unlimited);
+    if (!paths.cgroupMax.empty()) {
+        readNumber(paths.cgroupMax, sample.cgroupMax, unlimited);
+    }
+    
+    std::ifstream events(paths.cgroupEvents);
+    if (paths.cgroupEvents.empty() || !events) {
+        return found;
+    }
+    
+    uint64_t high = 0;
+    uint64_t max = 0;
+    uint64_t oom = 0;
+    std::string name;
+    uint64_t count = 0;
+    while (events >> name >> count) {
+        if (name == "high") {
+            high = count;
+        } else if (name == "max") {
+            max = count;
+        } else if (name == "oom" || name == "oom_kill") {
+            oom += count;
+        }
+    }
+    
+    // The counters are cumulative; only movement since the last sample says anything about now.
+    // The first sample just records the baseline.
+    if (eventsSeen) {
+        sample.newHighEvents = high - std::min(high, lastHighEvents);
+        sample.newMaxEvents = max - std::min(max, lastMaxEvents);
+        sample.newOomEvents = oom - std::min(oom, lastOomEvents);
+    }
+    eventsSeen = true;
+    lastHighEvents = high;
+    lastMaxEvents = max;
+    lastOomEvents = oom;
+    return true;
+}
+
+bool MemoryPressureMonitor::wait(std::chrono::milliseconds timeout) {
+#if MEMORY_PRESSURE_USE_PSI
+    struct pollfd fds[2];
+    nfds_t count = 0;
+    if (wakeFds[0] >= 0) {
+        fds[count++] = {wakeFds[0], POLLIN, 0};
+    }
+    if (triggerFd >= 0) {
+        fds[count++] = {triggerFd, POLLPRI, 0};
+    }
+    
+    int ready = poll(fds, count, static_cast<int>(timeout.count()));
+    if (ready <= 0) {
+        return false;
+    }
+    
+    bool triggered = false;
+    for (nfds_t i = 0; i < count; ++i) {
+        if (fds[i].fd == triggerFd && (fds[i].revents & POLLPRI)) {
+            triggered = true;
+        } else if (fds[i].fd == wakeFds[0] && (fds[i].revents & POLLIN)) {
+            char drain[64];
+            while (read(wakeFds[0], drain, sizeof(drain)) > 0) {}
+        }
+    }
+    return triggered;
+#else
+    std::this_thread::sleep_for(timeout);
+    return false;
+#endif
+}
+
+void MemoryPressureMonitor::interrupt() {
+#if MEMORY_PRESSURE_USE_PSI
+    if (wakeFds[1] >= 0) {
+        char wake = 1;
+        (void)!write(wakeFds[1], &wake, 1);
+    }
+#endif
+}
@@ -0,0 +1,106 @@
+#ifndef MEMORY_PRESSURE_H
+#define MEMORY_PRESSURE_H
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+
+// Memory pressure level, as fed to the GC scheduler
+enum class MemoryPressureLevel : int {
+    NONE,
+    MODERATE, // Tasks are stalling on memory some of the time, or the cgroup is nearing its limit
+    CRITICAL  // Every task is stalling, or the cgroup has hit its limit or the OOM killer
+};
+
+// Memory pressure paths: where the monitor reads from. Empty paths are skipped,
+// so tests can point every field at stand-in files
+struct MemoryPressurePaths {
+    std::string psi;           // PSI file, "some"/"full" lines with avg10 and total
+    std::string cgroupEvents;  // cgroup v2 memory.events
+    std::string cgroupCurrent; // cgroup v2 memory.current
+    std::string cgroupMax;     // cgroup v2 memory.max, "max" when unlimited
+    
+    // The system PSI file and the cgroup v2 files of the calling process's cgroup
+    static MemoryPressurePaths detect(const std::string& procRoot = "/proc",
+                                      const std::string& cgroupRoot = "/sys/fs/cgroup");
+};
+
+// Memory pressure sample: one reading of every available source
+struct MemoryPressureSample {
+    bool psiAvailable;
+    double someAvg10; // Percent of the last 10 s in which at least one task stalled on memory
+    double fullAvg10; // Percent in which all non-idle tasks stalled at once
+    bool cgroupAvailable;
+    size_t cgroupCurrent;
+    size_t cgroupMax; // 0 when unlimited
+    // memory.events counters that moved since the previous sample
+    uint64_t newHighEvents;
+    uint64_t newMaxEvents;
+    uint64_t newOomEvents;
+    MemoryPressureLevel level;
+};
+
+// Memory Pressure Monitor class
+// Reads Linux pressure stall information and cgroup v2 memory accounting and
+// boils them down to a pressure level. Where the kernel supports PSI triggers
+// the monitor registers one, so wait() returns as soon as stalls cross the
+// trigger instead of at the next poll. Elsewhere wait() is a plain timeout.
+class MemoryPressureMonitor {
+public:
+    // Thresholds in percent of wall time (PSI) or of memory.max (cgroup)
+    static constexpr double MODERATE_SOME_AVG10 = 10.0;
+    static constexpr double CRITICAL_FULL_AVG10 = 10.0;
+    static constexpr double MODERATE_CGROUP_USAGE = 80.0;
+    static constexpr double CRITICAL_CGROUP_USAGE = 95.0;
+    // PSI trigger: 100 ms of partial stall within a 2 s window. Unprivileged
+    // processes may only use windows that are multiples of 2 s.
+    static constexpr uint64_t TRIGGER_STALL_US = 100000;
+    static constexpr uint64_t TRIGGER_WINDOW_US = 2000000;
+    // How often to sample without a trigger, and while pressure persists
+    static constexpr std::chrono::milliseconds IDLE_POLL_INTERVAL{2000};
+    static constexpr std::chrono::milliseconds PRESSURED_POLL_INTERVAL{500};
+    // A memory.events bump keeps its level this long, like the avg10 window of PSI
+    static constexpr std::chrono::seconds EVENT_HOLD{10};
+    
+    explicit MemoryPressureMonitor(const MemoryPressurePaths& paths);
+    ~MemoryPressureMonitor();
+    
+    MemoryPressureMonitor(const MemoryPressureMonitor&) = delete;
+    MemoryPressureMonitor& operator=(const MemoryPressureMonitor&) = delete;
+    
+    const MemoryPressurePaths& getPaths() const;
+    // True when a PSI trigger is registered; only on procfs and cgroupfs, never on stand-in files
+    bool hasTrigger() const;
+    
+    // Reads every source and classifies the result; only the monitoring thread calls it
+    MemoryPressureSample sample();
+    // The most recent sample, for any thread
+    MemoryPressureSample getLastSample() const;
+    
+    // Blocks until the PSI trigger fires, the timeout passes or interrupt() is called;
+    // true only when the trigger fired
+    bool wait(std::chrono::milliseconds timeout);
+    void interrupt();
+    
+private:
+    bool readPsi(MemoryPressureSample& sample) const;
+    bool readCgroup(MemoryPressureSample& sample);
+    
+    MemoryPressurePaths paths;
+    int triggerFd;
+    int wakeFds[2]; // Self-pipe that interrupt() writes to
+    
+    bool eventsSeen;
+    uint64_t lastHighEvents;
+    uint64_t lastMaxEvents;
+    uint64_t lastOomEvents;
+    MemoryPressureLevel eventLevel;
+    std::chrono::steady_clock::time_point eventHoldUntil;
+    
+    mutable std::mutex lastSampleMutex;
+    MemoryPressureSample lastSample;
+};
+
+#endif // MEMORY_PRESSURE_H
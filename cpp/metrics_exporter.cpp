@@ -0,0 +1,196 @@
+#include "metrics_exporter.h"
+#include "memory_manager.h"
+#include "heap_backing.h"
+#include "memory_pressure.h"
+#include <cstdio>
+#include <cstring>
+#include <charconv>
+#include <algorithm>
+
+namespace {
+
+// Large enough for the full exposition, so steady-state renders never grow the buffer
+const size_t INITIAL_BUFFER_CAPACITY = 8192;
+
+void appendUnsigned(std::string& buffer, uint64_t value) {
+    char digits[24];
+    auto result = std::to_chars(digits, digits + sizeof(digits), value);
+    buffer.append(digits, result.ptr - digits);
+}
+
+void appendDouble(std::string& buffer, double value) {
+    char digits[32];
+    int length = std::snprintf(digits, sizeof(digits), "%.15g", value);
+    buffer.append(digits, length > 0 ? static_cast<size_t>(length) : 0);
+}
+
+} // namespace
+
+const char* const MetricsExporter::CONTENT_TYPE = "application/openmetrics-text; version=1.0.0; charset=utf-8";
+
+MetricsExporter::MetricsExporter(const MemoryManager& manager)
+    : manager(manager) {}
+
+void MetricsExporter::render(std::string& buffer) const {
+    buffer.clear();
+    if (buffer.capacity() < INITIAL_BUFFER_CAPACITY) {
+        buffer.reserve(INITIAL_BUFFER_CAPACITY);
+    }
+    
+    // Counters
+    appendFamily(buffer, "memmaster_gc_runs", "counter", "Garbage collections run since startup.");
+    appendSample(buffer, "memmaster_gc_runs_total", nullptr, static_cast<uint64_t>(manager.getGcRunsToday()));
+    
+    appendFamily(buffer, "memmaster_reclaimed_bytes", "counter", "Bytes reclaimed by collection and optimization.");
+    appendSample(buffer, "memmaster_reclaimed_bytes_total", nullptr,
+                 static_cast<uint64_t>(manager.getMemoryReclaimedTotal()));
+    
+    appendFamily(buffer, "memmaster_tlab_refills", "counter", "Thread-local allocation buffers reserved.");
+    appendSample(buffer, "memmaster_tlab_refills_total", nullptr, manager.getTlabRefills());
+    
+    appendFamily(buffer, "memmaster_tlab_allocated_bytes", "counter", "Bytes allocated from retired TLABs.");
+    appendSample(buffer, "memmaster_tlab_allocated_bytes_total", nullptr,
+                 static_cast<uint64_t>(manager.getTlabAllocatedBytes()));
+    
+    appendFamily(buffer, "memmaster_tlab_retired_bytes", "counter", "TLAB leftovers returned to the free lists.");
+    appendSample(buffer, "memmaster_tlab_retired_bytes_total", nullptr,
+                 static_cast<uint64_t>(manager.getTlabRetiredBytes()));
+    
+    appendFamily(buffer, "memmaster_tlab_waste_bytes", "counter", "TLAB leftovers too small to reuse.");
+    appendSample(buffer, "memmaster_tlab_waste_bytes_total", nullptr,
+                 static_cast<uint64_t>(manager.getTlabWasteBytes()));
+    
+    // Gauges
+    appendFamily(buffer, "memmaster_memory_total_bytes", "gauge", "Total managed memory.");
+    appendSample(buffer, "memmaster_memory_total_bytes", nullptr, static_cast<uint64_t>(manager.getTotalMemory()));
+    
+    appendFamily(buffer, "memmaster_memory_used_bytes", "gauge", "Used managed memory.");
+    appendSample(buffer, "memmaster_memory_used_bytes", nullptr, static_cast<uint64_t>(manager.getUsedMemory()));
+    
+    appendFamily(buffer, "memmaster_memory_free_bytes", "gauge", "Free managed memory.");
+    appendSample(buffer, "memmaster_memory_free_bytes", nullptr, static_cast<uint64_t>(manager.getFreeMemory()));
+    
+    appendFamily(buffer, "memmaster_fragmentation_ratio", "gauge", "Fraction of memory in fragmented blocks.");
+    appendSample(buffer, "memmaster_fragmentation_ratio", nullptr, manager.getFragmentation() / 100.0);
+    
+    appendFamily(buffer, "memmaster_slab_memory_bytes", "gauge", "Memory held in small-object slabs.");
+    appendSample(buffer, "memmaster_slab_memory_bytes", nullptr, static_cast<uint64_t>(manager.getSlabMemory()));
+    
+    appendFamily(buffer, "memmaster_slab_occupancy_ratio", "gauge", "Fraction of slab slots in use.");
+    appendSample(buffer, "memmaster_slab_occupancy_ratio", nullptr, manager.getSlabOccupancy() / 100.0);
+    
+    appendFamily(buffer, "memmaster_slab_internal_fragmentation_bytes", "gauge",
+                 "Slab memory not covered by live object bytes.");
+    appendSample(buffer, "memmaster_slab_internal_fragmentation_bytes", nullptr,
+                 static_cast<uint64_t>(manager.getSlabInternalFragmentation()));
+    
+    appendFamily(buffer, "memmaster_gc_cpu_impact_ratio", "gauge", "CPU impact of the last collection.");
+    appendSample(buffer, "memmaster_gc_cpu_impact_ratio", nullptr, manager.getCpuImpact() / 100.0);
+    
+    appendFamily(buffer, "memmaster_gc_average_duration_seconds", "gauge", "Average collection duration.");
+    appendSample(buffer, "memmaster_gc_average_duration_seconds", nullptr, manager.getAverageGcDuration() / 1000.0);
+    
+    appendFamily(buffer, "memmaster_gc_last_run_timestamp_seconds", "gauge", "Unix time of the last collection.");
+    auto lastRun = std::chrono::duration_cast<std::chrono::milliseconds>(
+        manager.getLastGcRun().time_since_epoch()).count();
+    appendSample(buffer, "memmaster_gc_last_run_timestamp_seconds", nullptr, lastRun / 1000.0);
+    
+    MemoryPressureSample pressure = manager.getMemoryPressure();
+    appendFamily(buffer, "memmaster_memory_pressure_level", "gauge",
+                 "Machine memory pressure fed to the GC scheduler: 0 none, 1 moderate, 2 critical.");
+    appendSample(buffer, "memmaster_memory_pressure_level", nullptr, static_cast<uint64_t>(pressure.level));
+    
+    if (pressure.psiAvailable) {
+        appendFamily(buffer, "memmaster_memory_stall_ratio", "gauge",
+                     "Share of the last 10 s with tasks stalled on memory, from /proc/pressure/memory.");
+        appendSample(buffer, "memmaster_memory_stall_ratio", "kind=\"some\"", pressure.someAvg10 / 100.0);
+        appendSample(buffer, "memmaster_memory_stall_ratio", "kind=\"full\"", pressure.fullAvg10 / 100.0);
+    }
+    
+    if (pressure.cgroupAvailable) {
+        appendFamily(buffer, "memmaster_cgroup_memory_bytes", "gauge", "The process cgroup's memory.current.");
+        appendSample(buffer, "memmaster_cgroup_memory_bytes", nullptr, static_cast<uint64_t>(pressure.cgroupCurrent));
+    }
+    
+    // Real-memory mode only; the residency is the pressure monitor's latest smaps reading, not read per scrape
+    if (manager.isMemoryBacked()) {
+        appendFamily(buffer, "memmaster_released_bytes", "counter", "Heap pages handed back to the OS with madvise.");
+        appendSample(buffer, "memmaster_released_bytes_total", nullptr,
+                     static_cast<uint64_t>(manager.getReleasedMemoryTotal()));
+        
+        HeapResidency residency = manager.getHeapResidency();
+        if (residency.available) {
+            appendFamily(buffer, "memmaster_resident_bytes", "gauge",
+                         "Resident heap memory per /proc/self/smaps, excluding lazily freed pages.");
+            appendSample(buffer, "memmaster_resident_bytes", nullptr,
+                         static_cast<uint64_t>(residency.rss - std::min(residency.rss, residency.lazyFree)));
+            
+            appendFamily(buffer, "memmaster_resident_huge_page_bytes", "gauge",
+                         "Resident heap memory backed by transparent huge pages.");
+            appendSample(buffer, "memmaster_resident_huge_page_bytes", nullptr,
+                         static_cast<uint64_t>(residency.anonHugePages));
+        }
+    }
+    
+    // Histograms
+    appendFamily(buffer, "memmaster_pause_seconds", "histogram", "Pause time of memory operations.");
+    appendHistogram(buffer, "memmaster_pause_seconds", "collection",
+                    manager.getPauseHistogram(PauseType::COLLECTION));
+    appendHistogram(buffer, "memmaster_pause_seconds", "optimization",
+                    manager.getPauseHistogram(PauseType::OPTIMIZATION));
+    appendHistogram(buffer, "memmaster_pause_seconds", "defragmentation",
+                    manager.getPauseHistogram(PauseType::DEFRAGMENTATION));
+    
+    buffer.append("# EOF\n");
+}
+
+void MetricsExporter::appendFamily(std::string& buffer, const char* name, const char* type, const char* help) {
+    buffer.append("# TYPE ").append(name).append(" ").append(type).append("\n");
+    buffer.append("# HELP ").append(name).append(" ").append(help).append("\n");
+}
+
+void MetricsExporter::appendSample(std::string& buffer, const char* name, const char* labels, uint64_t value) {
+    buffer.append(name);
+    if (labels) {
+        buffer.append("{").append(labels).append("}");
+    }
+    buffer.append(" ");
+    appendUnsigned(buffer, value);
+    buffer.append("\n");
+}
+
+void MetricsExporter::appendSample(std::string& buffer, const char* name, const char* labels, double value) {
+    buffer.append(name);
+    if (labels) {
+        buffer.append("{").append(labels).append("}");
+    }
+    buffer.append(" ");
+    appendDouble(buffer, value);
+    buffer.append("\n");
+}
+
+void MetricsExporter::appendHistogram(std::string& buffer, const char* name, const char* operation,
+                                      const PauseHistogram& histogram) {
+    // Read the total first so bucket counts can never exceed +Inf while collections are recording
+    uint64_t count = histogram.getCount();
+    
+    for (size_t i = 0; i < PauseHistogram::BUCKET_COUNT; ++i) {
+        buffer.append(name).append("_bucket{operation=\"").append(operation).append("\",le=\"");
+        appendDouble(buffer, PauseHistogram::BUCKET_BOUNDS_SECONDS[i]);
+        buffer.append("\"} ");
+        appendUnsigned(buffer, std::min(histogram.getCumulativeCount(i), count));
+        buffer.append("\n");
+    }
+    
+    buffer.append(name).append("_bucket{operation=\"").append(operation).append("\",le=\"+Inf\"} ");
+    appendUnsigned(buffer, count);
+    buffer.append("\n");
+    
+    buffer.append(name).append("_count{operation=\"").append(operation).append("\"} ");
+    appendUnsigned(buffer, count);
+    buffer.append("\n");
+    
+    buffer.append(name).append("_sum{operation=\"").append(operation).append("\"} ");
+    appendDouble(buffer, histogram.getSumSeconds());
+    buffer.append("\n");
+}
@@ -0,0 +1,33 @@
+#ifndef METRICS_EXPORTER_H
+#define METRICS_EXPORTER_H
+
+#include <string>
+#include <cstdint>
+
+class MemoryManager;
+class PauseHistogram;
+
+// Metrics Exporter class
+// Renders MemoryManager stats in OpenMetrics text format. Only lock-free
+// getters are read, and output is appended into a caller-owned buffer so
+// repeated scrapes reuse its capacity instead of allocating.
+class MetricsExporter {
+public:
+    static const char* const CONTENT_TYPE;
+    
+    explicit MetricsExporter(const MemoryManager& manager);
+    
+    // Clears buffer and renders the full exposition into it
+    void render(std::string& buffer) const;
+    
+private:
+    static void appendFamily(std::string& buffer, const char* name, const char* type, const char* help);
+    static void appendSample(std::string& buffer, const char* name, const char* labels, uint64_t value);
+    static void appendSample(std::string& buffer, const char* name, const char* labels, double value);
+    static void appendHistogram(std::string& buffer, const char* name, const char* operation,
+                                const PauseHistogram& histogram);
+    
+    const MemoryManager& manager;
+};
+
+#endif // METRICS_EXPORTER_H
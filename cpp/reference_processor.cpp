@@ -0,0 +1,82 @@
+#include "reference_processor.h"
+#include <algorithm>
+
+// WeakBlockReference implementation
+WeakBlockReference::WeakBlockReference(const std::shared_ptr<MemoryBlock>& block)
+    : block(block), cleared(false) {}
+
+bool WeakBlockReference::isCleared() const {
+    return cleared;
+}
+
+int WeakBlockReference::getBlockId() const {
+    return block->getId();
+}
+
+std::shared_ptr<MemoryBlock> WeakBlockReference::getBlock() const {
+    return cleared ? nullptr : block;
+}
+
+void WeakBlockReference::clear() {
+    cleared = true;
+}
+
+// ReferenceProcessor implementation
+ReferenceProcessor::ReferenceProcessor()
+    : clearedReferences(0) {}
+
+std::shared_ptr<WeakBlockReference> ReferenceProcessor::createWeakReference(const std::shared_ptr<MemoryBlock>& block) {
+    auto reference = std::make_shared<WeakBlockReference>(block);
+    
+    std::lock_guard<std::mutex> lock(mutex);
+    auto& weakReferences = entries[block.get()].weakReferences;
+    weakReferences.erase(std::remove_if(weakReferences.begin(), weakReferences.end(),
+                                        [](const std::weak_ptr<WeakBlockReference>& weak) { return weak.expired(); }),
+                         weakReferences.end());
+    weakReferences.push_back(reference);
+    block->addReferenceFlags(MemoryBlock::WEAKLY_REFERENCED);
+    return reference;
+}
+
+void ReferenceProcessor::registerFinalizer(const std::shared_ptr<MemoryBlock>& block, BlockFinalizer finalizer) {
+    std::lock_guard<std::mutex> lock(mutex);
+    entries[block.get()].finalizer = std::move(finalizer);
+    block->addReferenceFlags(MemoryBlock::FINALIZABLE);
+}
+
+BlockFinalizer ReferenceProcessor::clearReferences(MemoryBlock& block) {
+    std::lock_guard<std::mutex> lock(mutex);
+    block.clearReferenceFlags();
+    
+    auto found = entries.find(&block);
+    if (found == entries.end()) {
+        return nullptr;
+    }
+    
+    for (const auto& weak : found->second.weakReferences) {
+        if (auto reference = weak.lock()) {
+            reference->clear();
+            clearedReferences.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+    BlockFinalizer finalizer = std::move(found->second.finalizer);
+    entries.erase(found);
+    return finalizer;
+}
+
+void ReferenceProcessor::clear() {
+    std::lock_guard<std::mutex> lock(mutex);
+    for (auto& entry : entries) {
+        for (const auto& weak : entry.second.weakReferences) {
+            if (auto reference = weak.lock()) {
+                reference->clear();
+                clearedReferences.fetch_add(1, std::memory_order_relaxed);
+            }
+        }
+    }
+    entries.clear();
+}
+
+uint64_t ReferenceProcessor::getClearedReferences() const {
+    return clearedReferences.load(std::memory_order_relaxed);
+}
@@ -0,0 +1,59 @@
+#ifndef REFERENCE_PROCESSOR_H
+#define REFERENCE_PROCESSOR_H
+
+#include "memory_manager.h"
+#include <unordered_map>
+
+// Weak Block Reference class
+// Names a block without keeping it alive. Once a collection finds the block
+// dead the reference is cleared, before the block's memory can be reused, so
+// a reference that is not cleared always names the block it was made for.
+class WeakBlockReference {
+public:
+    explicit WeakBlockReference(const std::shared_ptr<MemoryBlock>& block);
+    
+    bool isCleared() const;
+    int getBlockId() const;
+    // The block handle for identification only; MemoryManager::getWeakReferent() returns a usable block
+    std::shared_ptr<MemoryBlock> getBlock() const;
+    // Called by the reference processor
+    void clear();
+    
+private:
+    std::shared_ptr<MemoryBlock> block;
+    std::atomic<bool> cleared;
+};
+
+// Reference Processor class
+// Holds the weak references and finalizer of every block that has any, keyed
+// by block. Blocks carry matching reference flags, so sweeps only consult the
+// table for the dead blocks that need it.
+class ReferenceProcessor {
+public:
+    ReferenceProcessor();
+    
+    ReferenceProcessor(const ReferenceProcessor&) = delete;
+    ReferenceProcessor& operator=(const ReferenceProcessor&) = delete;
+    
+    std::shared_ptr<WeakBlockReference> createWeakReference(const std::shared_ptr<MemoryBlock>& block);
+    void registerFinalizer(const std::shared_ptr<MemoryBlock>& block, BlockFinalizer finalizer);
+    // The block is dead: clears its weak references and flags and returns its finalizer, if it had one
+    BlockFinalizer clearReferences(MemoryBlock& block);
+    // The heap was replaced wholesale: clears every weak reference and drops every finalizer
+    void clear();
+    
+    uint64_t getClearedReferences() const;
+    
+private:
+    struct Entry {
+        // Weak so references the caller dropped do not pile up while the block lives
+        std::vector<std::weak_ptr<WeakBlockReference>> weakReferences;
+        BlockFinalizer finalizer;
+    };
+    
+    mutable std::mutex mutex;
+    std::unordered_map<const MemoryBlock*, Entry> entries;
+    std::atomic<uint64_t> clearedReferences;
+};
+
+#endif // REFERENCE_PROCESSOR_H
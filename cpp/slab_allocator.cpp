@@ -0,0 +1,299 @@
+#include "slab_allocator.h"
+#include <algorithm>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace {
+
+// Index of the lowest set bit; word must be non-zero
+inline size_t findFirstSet(uint64_t word) {
+#if defined(_MSC_VER)
+    unsigned long index;
+    _BitScanForward64(&index, word);
+    return index;
+#else
+    return static_cast<size_t>(__builtin_ctzll(word));
+#endif
+}
+
+} // namespace
+
+// Slab implementation
+Slab::Slab(const std::shared_ptr<MemoryBlock>& block, size_t slotSize)
+    : block(block), slotSize(slotSize), slotCount(block->getSize() / slotSize), freeSlots(0),
+      liveBytes(0), searchHint(0), bitmap((slotCount + 63) / 64, ~0ULL) {
+    freeSlots = slotCount;
+    
+    // Clear the bits past the last slot so they are never handed out
+    if (slotCount % 64 != 0) {
+        bitmap.back() = (1ULL << (slotCount % 64)) - 1;
+    }
+}
+
+const std::shared_ptr<MemoryBlock>& Slab::getBlock() const {
+    return block;
+}
+
+size_t Slab::getSlotSize() const {
+    return slotSize;
+}
+
+size_t Slab::getSlotCount() const {
+    return slotCount;
+}
+
+size_t Slab::getFreeSlots() const {
+    return freeSlots;
+}
+
+size_t Slab::getLiveBytes() const {
+    return liveBytes;
+}
+
+bool Slab::isFull() const {
+    return freeSlots == 0;
+}
+
+bool Slab::isEmpty() const {
+    return freeSlots == slotCount;
+}
+
+size_t Slab::allocateSlot(size_t requestedSize) {
+    while (bitmap[searchHint] == 0) {
+        ++searchHint;
+    }
+    
+    uint64_t& word = bitmap[searchHint];
+    size_t bit = findFirstSet(word);
+    word &= word - 1; // Clear the lowest set bit
+    
+    --freeSlots;
+    liveBytes += requestedSize;
+    return searchHint * 64 + bit;
+}
+
+bool Slab::freeSlot(size_t index, size_t requestedSize) {
+    if (index >= slotCount) {
+        return false;
+    }
+    
+    size_t wordIndex = index / 64;
+    uint64_t mask = 1ULL << (index % 64);
+    if (bitmap[wordIndex] & mask) {
+        return false;
+    }
+    
+    bitmap[wordIndex] |= mask;
+    searchHint = std::min(searchHint, wordIndex);
+    ++freeSlots;
+    liveBytes -= requestedSize;
+    return true;
+}
+
+// SlabAllocator implementation
+SlabAllocator::SizeClass::SizeClass(size_t slotSize)
+    : slotSize(slotSize) {}
+
+SlabAllocator::SlabAllocator(AcquireSlabFunction acquireSlab, ReleaseSlabFunction releaseSlab)
+    : acquireSlab(std::move(acquireSlab)), releaseSlab(std::move(releaseSlab)),
+      slabMemory(0), liveBytes(0), usedSlotBytes(0) {
+    
+    // 16-byte steps up to 128 B, then four classes per doubling up to MAX_OBJECT_SIZE
+    for (size_t size = MIN_OBJECT_SIZE; size <= 128; size += 16) {
+        sizeClasses.push_back(std::make_unique<SizeClass>(size));
+    }
+    for (size_t base = 128; base < MAX_OBJECT_SIZE; base *= 2) {
+        for (size_t step = 1; step <= 4; ++step) {
+            sizeClasses.push_back(std::make_unique<SizeClass>(base + step * base / 4));
+        }
+    }
+    
+    classLookup.resize(MAX_OBJECT_SIZE / 16 + 1);
+    size_t classIndex = 0;
+    for (size_t i = 0; i < classLookup.size(); ++i) {
+        while (sizeClasses[classIndex]->slotSize < std::max(i * 16, MIN_OBJECT_SIZE)) {
+            ++classIndex;
+        }
+        classLookup[i] = static_cast<uint8_t>(classIndex);
+    }
+}
+
+bool SlabAllocator::allocate(size_t size, ObjectAllocation& allocation) {
+    if (size == 0 || size > MAX_OBJECT_SIZE) {
+        return false;
+    }
+    
+    SizeClass& sizeClass = *sizeClasses[getClassIndex(size)];
+    std::lock_guard<std::mutex> lock(sizeClass.mutex);
+    
+    Slab* slab = nullptr;
+    while (!sizeClass.partialSlabs.empty()) {
+        slab = sizeClass.partialSlabs.back();
+        
+        // A collection that freed the slab's block took its objects with it
+        if (slab->getBlock()->getStatus() == BlockStatus::ACTIVE) {
+            break;
+        }
+        dropSlab(sizeClass, slab, false);
+        slab = nullptr;
+    }
+    
+    if (!slab) {
+        auto block = acquireSlab(SLAB_SIZE);
+        if (!block) {
+            return false;
+        }
+        
+        auto newSlab = std::make_unique<Slab>(block, sizeClass.slotSize);
+        slab = newSlab.get();
+        sizeClass.slabs.emplace(block->getId(), std::move(newSlab));
+        {
+            std::lock_guard<std::mutex> classesLock(slabClassesMutex);
+            slabClasses[block->getId()] = static_cast<uint8_t>(getClassIndex(size));
+        }
+        sizeClass.partialSlabs.push_back(slab);
+        slabMemory += block->getSize();
+    }
+    
+    size_t slot = slab->allocateSlot(size);
+    if (slab->isFull()) {
+        sizeClass.partialSlabs.pop_back();
+    }
+    
+    liveBytes += size;
+    usedSlotBytes += sizeClass.slotSize;
+    
+    allocation.blockId = slab->getBlock()->getId();
+    allocation.offset = slot * sizeClass.slotSize;
+    allocation.size = size;
+    return true;
+}
+
+bool SlabAllocator::free(const ObjectAllocation& allocation) {
+    if (allocation.size == 0 || allocation.size > MAX_OBJECT_SIZE) {
+        return false;
+    }
+    
+    // The slab decides the size class; a size from another class would free the wrong slot
+    int classIndex = findSlabClass(allocation.blockId);
+    if (classIndex < 0 || static_cast<size_t>(classIndex) != getClassIndex(allocation.size)) {
+        return false;
+    }
+    
+    SizeClass& sizeClass = *sizeClasses[classIndex];
+    if (allocation.offset % sizeClass.slotSize != 0) {
+        return false;
+    }
+    std::lock_guard<std::mutex> lock(sizeClass.mutex);
+    
+    // The slab may have been dropped, and its block reused by another class, since the lookup
+    auto it = sizeClass.slabs.find(allocation.blockId);
+    if (it == sizeClass.slabs.end()) {
+        return false;
+    }
+    
+    Slab* slab = it->second.get();
+    bool wasFull = slab->isFull();
+    if (!slab->freeSlot(allocation.offset / sizeClass.slotSize, allocation.size)) {
+        return false;
+    }
+    
+    liveBytes -= allocation.size;
+    usedSlotBytes -= sizeClass.slotSize;
+    
+    if (slab->getBlock()->getStatus() != BlockStatus::ACTIVE) {
+        dropSlab(sizeClass, slab, false);
+        return true;
+    }
+    
+    if (wasFull) {
+        sizeClass.partialSlabs.push_back(slab);
+    }
+    
+    // Hand empty slabs back to the block heap, keeping one per class to absorb churn
+    if (slab->isEmpty() && sizeClass.partialSlabs.size() > 1) {
+        dropSlab(sizeClass, slab, true);
+    }
+    
+    return true;
+}
+
+void SlabAllocator::dropDeadSlabs() {
+    for (auto& sizeClass : sizeClasses) {
+        std::lock_guard<std::mutex> lock(sizeClass->mutex);
+        
+        std::vector<Slab*> deadSlabs;
+        for (const auto& entry : sizeClass->slabs) {
+            if (entry.second->getBlock()->getStatus() != BlockStatus::ACTIVE) {
+                deadSlabs.push_back(entry.second.get());
+            }
+        }
+        for (Slab* slab : deadSlabs) {
+            dropSlab(*sizeClass, slab, false);
+        }
+    }
+}
+
+size_t SlabAllocator::getSizeClassCount() const {
+    return sizeClasses.size();
+}
+
+size_t SlabAllocator::getSizeClass(size_t index) const {
+    return sizeClasses.at(index)->slotSize;
+}
+
+size_t SlabAllocator::getSlabMemory() const {
+    return slabMemory;
+}
+
+size_t SlabAllocator::getLiveBytes() const {
+    return liveBytes;
+}
+
+size_t SlabAllocator::getInternalFragmentation() const {
+    size_t slabs = slabMemory;
+    size_t live = liveBytes;
+    return slabs > live ? slabs - live : 0;
+}
+
+float SlabAllocator::getOccupancy() const {
+    size_t slabs = slabMemory;
+    if (slabs == 0) {
+        return 0.0f;
+    }
+    return static_cast<float>(usedSlotBytes) / slabs * 100.0f;
+}
+
+size_t SlabAllocator::getClassIndex(size_t size) const {
+    return classLookup[(size + 15) / 16];
+}
+
+int SlabAllocator::findSlabClass(int blockId) const {
+    std::lock_guard<std::mutex> lock(slabClassesMutex);
+    auto it = slabClasses.find(blockId);
+    return it != slabClasses.end() ? it->second : -1;
+}
+
+void SlabAllocator::dropSlab(SizeClass& sizeClass, Slab* slab, bool returnToHeap) {
+    auto partial = std::find(sizeClass.partialSlabs.begin(), sizeClass.partialSlabs.end(), slab);
+    if (partial != sizeClass.partialSlabs.end()) {
+        sizeClass.partialSlabs.erase(partial);
+    }
+    
+    slabMemory -= slab->getBlock()->getSize();
+    liveBytes -= slab->getLiveBytes();
+    usedSlotBytes -= (slab->getSlotCount() - slab->getFreeSlots()) * sizeClass.slotSize;
+    
+    // Forget the block before releasing it, or a slab of another class built on it could lose its entry
+    {
+        std::lock_guard<std::mutex> classesLock(slabClassesMutex);
+        slabClasses.erase(slab->getBlock()->getId());
+    }
+    
+    if (returnToHeap) {
+        releaseSlab(slab->getBlock());
+    }
+    sizeClass.slabs.erase(slab->getBlock()->getId());
+}
@@ -0,0 +1,99 @@
+#ifndef SLAB_ALLOCATOR_H
+#define SLAB_ALLOCATOR_H
+
+#include "memory_manager.h"
+#include <unordered_map>
+
+// Slab class
+// One block carved into equal slots. A set bit in the occupancy bitmap marks
+// a free slot, so the next free slot is a bit scan away.
+class Slab {
+public:
+    Slab(const std::shared_ptr<MemoryBlock>& block, size_t slotSize);
+    
+    const std::shared_ptr<MemoryBlock>& getBlock() const;
+    size_t getSlotSize() const;
+    size_t getSlotCount() const;
+    size_t getFreeSlots() const;
+    size_t getLiveBytes() const;
+    bool isFull() const;
+    bool isEmpty() const;
+    
+    // Caller checks isFull() first
+    size_t allocateSlot(size_t requestedSize);
+    // False if the slot was already free
+    bool freeSlot(size_t index, size_t requestedSize);
+    
+private:
+    std::shared_ptr<MemoryBlock> block;
+    size_t slotSize;
+    size_t slotCount;
+    size_t freeSlots;
+    size_t liveBytes;
+    size_t searchHint; // First bitmap word that may have a free slot
+    std::vector<uint64_t> bitmap;
+};
+
+// Slab Allocator class
+// Size-class allocator for small objects. Slabs are reserved from the block
+// heap and handed back as soon as they empty out.
+class SlabAllocator {
+public:
+    static constexpr size_t MIN_OBJECT_SIZE = 16;
+    static constexpr size_t MAX_OBJECT_SIZE = 8 * 1024;
+    static constexpr size_t SLAB_SIZE = 64 * 1024;
+    
+    using AcquireSlabFunction = std::function<std::shared_ptr<MemoryBlock>(size_t size)>;
+    using ReleaseSlabFunction = std::function<void(const std::shared_ptr<MemoryBlock>& block)>;
+    
+    SlabAllocator(AcquireSlabFunction acquireSlab, ReleaseSlabFunction releaseSlab);
+    
+    bool allocate(size_t size, ObjectAllocation& allocation);
+    // False unless allocation names a live slot: its slab is found by block id, the offset must be
+    // slot-aligned and the size must belong to the slab's size class
+    bool free(const ObjectAllocation& allocation);
+    // Forgets every slab whose block is no longer active, such as after a restore replaced the block heap
+    void dropDeadSlabs();
+    
+    size_t getSizeClassCount() const;
+    size_t getSizeClass(size_t index) const;
+    
+    // Stats, readable without any lock
+    size_t getSlabMemory() const;
+    size_t getLiveBytes() const;
+    size_t getInternalFragmentation() const;
+    float getOccupancy() const;
+    
+private:
+    struct SizeClass {
+        explicit SizeClass(size_t slotSize);
+        
+        size_t slotSize;
+        std::mutex mutex;
+        std::unordered_map<int, std::unique_ptr<Slab>> slabs;
+        std::vector<Slab*> partialSlabs;
+    };
+    
+    size_t getClassIndex(size_t size) const;
+    // Size class of the slab on blockId, or -1 if no slab uses that block
+    int findSlabClass(int blockId) const;
+    // Caller holds the size class mutex
+    void dropSlab(SizeClass& sizeClass, Slab* slab, bool returnToHeap);
+    
+    AcquireSlabFunction acquireSlab;
+    ReleaseSlabFunction releaseSlab;
+    
+    std::vector<std::unique_ptr<SizeClass>> sizeClasses;
+    std::vector<uint8_t> classLookup; // Indexed by (size + 15) / 16
+    
+    // Which size class owns each slab block, so a free never trusts the caller's size to find it.
+    // Taken inside a size class mutex, never around one.
+    mutable std::mutex slabClassesMutex;
+    std::unordered_map<int, uint8_t> slabClasses;
+    
+    std::atomic<size_t> slabMemory;
+    std::atomic<size_t> liveBytes;
+    std::atomic<size_t> usedSlotBytes;
+};
+
+#endif // SLAB_ALLOCATOR_H
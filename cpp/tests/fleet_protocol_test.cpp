@@ -0,0 +1,227 @@
+#include "../fleet_protocol.h"
+#include "test_util.h"
+
+namespace {
+
+// Splits the first frame off buffer; false if the header is rejected or the payload is cut short
+bool takeFrame(std::string& buffer, uint8_t& type, std::string& payload) {
+    uint32_t payloadSize = 0;
+    if (buffer.size() < FleetProtocol::HEADER_SIZE ||
+        !FleetProtocol::decodeHeader(buffer.data(), type, payloadSize) ||
+        buffer.size() - FleetProtocol::HEADER_SIZE < payloadSize) {
+        return false;
+    }
+    payload = buffer.substr(FleetProtocol::HEADER_SIZE, payloadSize);
+    buffer.erase(0, FleetProtocol::HEADER_SIZE + payloadSize);
+    return true;
+}
+
+FleetStats makeStats() {
+    FleetStats stats;
+    stats.timestampMs = 1760000000000ULL;
+    stats.totalMemory = 10ULL * 1024 * 1024 * 1024;
+    stats.usedMemory = 123456789;
+    stats.freeMemory = stats.totalMemory - stats.usedMemory;
+    stats.fragmentation = 12.5f;
+    stats.pressureLevel = 2;
+    stats.gcRuns = 42;
+    stats.memoryReclaimed = UINT64_MAX;
+    stats.releasedMemory = 0;
+    for (size_t i = 0; i < stats.pauses.size(); ++i) {
+        FleetHistogram& histogram = stats.pauses[i];
+        histogram.count = 100 + i;
+        histogram.sumMicros = 987654 * (i + 1);
+        for (size_t j = 0; j < histogram.buckets.size(); ++j) {
+            histogram.buckets[j] = j % 3 == 0 ? 0 : j * 1000 + i;
+        }
+    }
+    return stats;
+}
+
+FleetActivity makeActivity(int id) {
+    return FleetActivity{0, id, -id % 5, 1760000000000LL + id, id % 1000, 4096ULL * id, -id, 0.25f * id,
+                         static_cast<uint64_t>(id) * 17, static_cast<uint64_t>(id) * 3};
+}
+
+void testHello() {
+    FleetHello hello{0x0123456789abcdefULL, 4242, "instance-a"};
+    std::string buffer;
+    FleetProtocol::encodeHello(buffer, hello);
+    
+    uint8_t type = 0;
+    std::string payload;
+    CHECK(takeFrame(buffer, type, payload));
+    CHECK(type == static_cast<uint8_t>(FleetMessageType::HELLO));
+    CHECK(buffer.empty());
+    
+    FleetHello decoded;
+    CHECK(FleetProtocol::decodeHello(payload.data(), payload.size(), decoded));
+    CHECK(decoded.instanceId == hello.instanceId);
+    CHECK(decoded.pid == hello.pid);
+    CHECK(decoded.name == hello.name);
+    
+    // Peers speaking another version are turned away
+    std::string otherVersion = payload;
+    otherVersion[0] = static_cast<char>(FleetProtocol::VERSION + 1);
+    CHECK(!FleetProtocol::decodeHello(otherVersion.data(), otherVersion.size(), decoded));
+    
+    // Long names are cut to MAX_NAME_LENGTH on the way out
+    FleetHello longName{1, 1, std::string(FleetProtocol::MAX_NAME_LENGTH + 50, 'n')};
+    FleetProtocol::encodeHello(buffer, longName);
+    CHECK(takeFrame(buffer, type, payload));
+    CHECK(FleetProtocol::decodeHello(payload.data(), payload.size(), decoded));
+    CHECK(decoded.name.size() == FleetProtocol::MAX_NAME_LENGTH);
+}
+
+void testStats() {
+    FleetStats stats = makeStats();
+    std::string buffer;
+    FleetProtocol::encodeStats(buffer, stats);
+    
+    uint8_t type = 0;
+    std::string payload;
+    CHECK(takeFrame(buffer, type, payload));
+    CHECK(type == static_cast<uint8_t>(FleetMessageType::STATS));
+    
+    FleetStats decoded;
+    CHECK(FleetProtocol::decodeStats(payload.data(), payload.size(), decoded));
+    CHECK(decoded.timestampMs == stats.timestampMs);
+    CHECK(decoded.totalMemory == stats.totalMemory);
+    CHECK(decoded.usedMemory == stats.usedMemory);
+    CHECK(decoded.freeMemory == stats.freeMemory);
+    CHECK(decoded.fragmentation == stats.fragmentation);
+    CHECK(decoded.pressureLevel == stats.pressureLevel);
+    CHECK(decoded.gcRuns == stats.gcRuns);
+    CHECK(decoded.memoryReclaimed == stats.memoryReclaimed);
+    CHECK(decoded.releasedMemory == stats.releasedMemory);
+    for (size_t i = 0; i < stats.pauses.size(); ++i) {
+        CHECK(decoded.pauses[i].count == stats.pauses[i].count);
+        CHECK(decoded.pauses[i].sumMicros == stats.pauses[i].sumMicros);
+        CHECK(decoded.pauses[i].buckets == stats.pauses[i].buckets);
+    }
+}
+
+void testActivities() {
+    // More than one frame's worth is split across frames
+    std::vector<FleetActivity> activities;
+    for (int i = 1; i <= static_cast<int>(FleetProtocol::MAX_ACTIVITIES_PER_FRAME * 2 + 10); ++i) {
+        activities.push_back(makeActivity(i));
+    }
+    std::string buffer;
+    FleetProtocol::encodeActivities(buffer, activities.data(), activities.size());
+    
+    std::vector<FleetActivity> decoded;
+    uint8_t type = 0;
+    std::string payload;
+    size_t frames = 0;
+    while (takeFrame(buffer, type, payload)) {
+        CHECK(type == static_cast<uint8_t>(FleetMessageType::ACTIVITIES));
+        CHECK(payload.size() <= FleetProtocol::MAX_PAYLOAD_SIZE);
+        CHECK(FleetProtocol::decodeActivities(payload.data(), payload.size(), decoded));
+        ++frames;
+    }
+    CHECK(buffer.empty());
+    CHECK(frames == 3);
+    CHECK(decoded.size() == activities.size());
+    
+    for (size_t i = 0; i < decoded.size() && i < activities.size(); ++i) {
+        const FleetActivity& a = activities[i];
+        const FleetActivity& b = decoded[i];
+        CHECK(b.instanceId == 0);
+        CHECK(a.id == b.id && a.algorithmId == b.algorithmId && a.timestampMs == b.timestampMs);
+        CHECK(a.durationMs == b.durationMs && a.memoryReclaimed == b.memoryReclaimed);
+        CHECK(a.objectsCollected == b.objectsCollected && a.cpuImpact == b.cpuImpact);
+        CHECK(a.pauseMicros == b.pauseMicros && a.referenceProcessingMicros == b.referenceProcessingMicros);
+    }
+}
+
+void testTruncatedPayloads() {
+    std::string buffer;
+    FleetProtocol::encodeHello(buffer, FleetHello{7, 8, "name"});
+    FleetProtocol::encodeStats(buffer, makeStats());
+    FleetActivity activities[] = {makeActivity(1), makeActivity(2)};
+    FleetProtocol::encodeActivities(buffer, activities, 2);
+    
+    uint8_t type = 0;
+    std::string payload;
+    while (takeFrame(buffer, type, payload)) {
+        // Every strict prefix is rejected, and so is a trailing byte
+        for (size_t length = 0; length <= payload.size(); ++length) {
+            std::string data = length < payload.size() ? payload.substr(0, length) : payload + '\0';
+            FleetHello hello;
+            FleetStats stats;
+            std::vector<FleetActivity> decoded(1, makeActivity(99));
+            bool accepted = false;
+            switch (static_cast<FleetMessageType>(type)) {
+                case FleetMessageType::HELLO:
+                    accepted = FleetProtocol::decodeHello(data.data(), data.size(), hello);
+                    break;
+                case FleetMessageType::STATS:
+                    accepted = FleetProtocol::decodeStats(data.data(), data.size(), stats);
+                    break;
+                case FleetMessageType::ACTIVITIES:
+                    accepted = FleetProtocol::decodeActivities(data.data(), data.size(), decoded);
+                    // A rejected frame leaves what was already decoded alone
+                    CHECK(decoded.size() == 1 && decoded[0].id == 99);
+                    break;
+            }
+            CHECK(!accepted);
+        }
+    }
+    
+    // A frame whose payload has not fully arrived is not taken
+    FleetProtocol::encodeHello(buffer, FleetHello{7, 8, "name"});
+    buffer.pop_back();
+    CHECK(!takeFrame(buffer, type, payload));
+    
+    // A varint that never ends
+    std::string endless(11, static_cast<char>(0x80));
+    FleetHello hello;
+    CHECK(!FleetProtocol::decodeHello(endless.data(), endless.size(), hello));
+}
+
+void testOversizedFrames() {
+    char header[FleetProtocol::HEADER_SIZE];
+    uint8_t type = 0;
+    uint32_t payloadSize = 0;
+    
+    auto writeHeader = [&header](uint32_t size) {
+        header[0] = static_cast<char>(FleetMessageType::STATS);
+        for (int i = 0; i < 4; ++i) {
+            header[1 + i] = static_cast<char>(size >> (8 * i));
+        }
+    };
+    
+    writeHeader(FleetProtocol::MAX_PAYLOAD_SIZE);
+    CHECK(FleetProtocol::decodeHeader(header, type, payloadSize));
+    CHECK(payloadSize == FleetProtocol::MAX_PAYLOAD_SIZE);
+    
+    writeHeader(FleetProtocol::MAX_PAYLOAD_SIZE + 1);
+    CHECK(!FleetProtocol::decodeHeader(header, type, payloadSize));
+    
+    writeHeader(UINT32_MAX);
+    CHECK(!FleetProtocol::decodeHeader(header, type, payloadSize));
+    
+    // An activity count past the per-frame limit is refused before anything is read
+    std::string payload;
+    uint64_t count = FleetProtocol::MAX_ACTIVITIES_PER_FRAME + 1;
+    while (count >= 0x80) {
+        payload.push_back(static_cast<char>((count & 0x7f) | 0x80));
+        count >>= 7;
+    }
+    payload.push_back(static_cast<char>(count));
+    std::vector<FleetActivity> decoded;
+    CHECK(!FleetProtocol::decodeActivities(payload.data(), payload.size(), decoded));
+    CHECK(decoded.empty());
+}
+
+} // namespace
+
+int main() {
+    testHello();
+    testStats();
+    testActivities();
+    testTruncatedPayloads();
+    testOversizedFrames();
+    return testResult("fleet_protocol_test");
+}
@@ -0,0 +1,71 @@
+#include "../gc_kernels.h"
+#include "test_util.h"
+
+#include <cmath>
+
+namespace {
+
+const size_t BLOCK_COUNT = 100000;
+
+std::vector<std::shared_ptr<MemoryBlock>> makeActiveBlocks() {
+    std::vector<std::shared_ptr<MemoryBlock>> blocks;
+    for (size_t i = 0; i < BLOCK_COUNT; ++i) {
+        blocks.push_back(std::make_shared<MemoryBlock>(static_cast<int>(i + 1), 64, BlockStatus::ACTIVE));
+    }
+    return blocks;
+}
+
+template <typename Policy>
+void checkReclaimRate(const char* name) {
+    // Every priority reclaims at the policy's own rate
+    const SweepKernels kernels = makeSweepKernels<Policy>();
+    for (size_t priority = 0; priority < kernels.size(); ++priority) {
+        auto blocks = makeActiveBlocks();
+        SweepRandom random(12345 + priority);
+        std::vector<std::shared_ptr<MemoryBlock>> discovered;
+        
+        size_t reclaimed = kernels[priority](blocks, random, nullptr, discovered);
+        double rate = static_cast<double>(reclaimed / 64) / BLOCK_COUNT;
+        if (std::fabs(rate - Policy::RECLAIM_PROBABILITY) > 0.01) {
+            std::cerr << name << " priority " << priority << ": reclaimed " << rate << std::endl;
+        }
+        CHECK(std::fabs(rate - Policy::RECLAIM_PROBABILITY) <= 0.01);
+        CHECK(discovered.empty());
+    }
+}
+
+void testSkippedBlocks() {
+    auto blocks = makeActiveBlocks();
+    for (size_t i = 0; i < BLOCK_COUNT; i += 2) {
+        CHECK(blocks[i]->setPinned(true));
+    }
+    for (size_t i = 1; i < BLOCK_COUNT; i += 4) {
+        blocks[i]->addReferenceFlags(MemoryBlock::FINALIZABLE);
+    }
+    
+    SweepRandom random(7);
+    std::vector<std::shared_ptr<MemoryBlock>> discovered;
+    sweepKernel<GenerationalPolicy, CollectionPriority::BALANCED>(blocks, random, nullptr, discovered);
+    
+    // Pinned blocks are never touched; dead blocks with reference state are handed on, still active
+    for (size_t i = 0; i < BLOCK_COUNT; i += 2) {
+        CHECK(blocks[i]->getStatus() == BlockStatus::ACTIVE);
+    }
+    CHECK(!discovered.empty());
+    for (const auto& block : discovered) {
+        CHECK(block->getReferenceFlags() == MemoryBlock::FINALIZABLE);
+        CHECK(block->getStatus() == BlockStatus::ACTIVE);
+    }
+}
+
+} // namespace
+
+int main() {
+    checkReclaimRate<MarkSweepPolicy>("MarkSweep");
+    checkReclaimRate<GenerationalPolicy>("Generational");
+    checkReclaimRate<ReferenceCountingPolicy>("ReferenceCounting");
+    checkReclaimRate<ConcurrentGcPolicy>("ConcurrentGc");
+    checkReclaimRate<RegionEvacuationPolicy>("RegionEvacuation");
+    testSkippedBlocks();
+    return testResult("gc_kernels_test");
+}
@@ -0,0 +1,172 @@
+#include "../heap_map.h"
+#include "test_util.h"
+
+#include <algorithm>
+#include <array>
+
+namespace {
+
+std::vector<BlockStatus> pixelsFrom(const std::string& text) {
+    std::vector<BlockStatus> pixels;
+    for (char c : text) {
+        pixels.push_back(c == 'A' ? BlockStatus::ACTIVE : c == 'X' ? BlockStatus::FRAGMENTED : BlockStatus::FREE);
+    }
+    return pixels;
+}
+
+// Applies an update to a client's copy of the map
+void applyUpdate(std::vector<BlockStatus>& pixels, const HeapMapUpdate& update) {
+    if (update.full) {
+        pixels.assign(update.width, BlockStatus::FREE);
+    }
+    for (const auto& range : update.ranges) {
+        uint32_t i = range.start;
+        for (const auto& run : range.runs) {
+            for (uint32_t j = 0; j < run.length; ++j) {
+                pixels[i++] = run.status;
+            }
+        }
+    }
+}
+
+void testDiffsAcrossVersions() {
+    uint64_t versions = 0;
+    HeapMap map(32, versions);
+    auto now = std::chrono::steady_clock::now();
+    
+    map.refresh(pixelsFrom("AAAA............................"), now);
+    HeapMapUpdate first = map.getUpdate(0);
+    CHECK(first.full);
+    std::vector<BlockStatus> client;
+    applyUpdate(client, first);
+    uint64_t clientVersion = first.version;
+    
+    // Unchanged pixels keep the version
+    map.refresh(pixelsFrom("AAAA............................"), now);
+    CHECK(map.getVersion() == clientVersion);
+    HeapMapUpdate unchanged = map.getUpdate(clientVersion);
+    CHECK(!unchanged.full && unchanged.ranges.empty());
+    
+    // Two changes later, one diff covers both
+    map.refresh(pixelsFrom("AAAA....AA......................"), now);
+    map.refresh(pixelsFrom("AAAA....AA...................XX."), now);
+    HeapMapUpdate diff = map.getUpdate(clientVersion);
+    CHECK(!diff.full);
+    CHECK(diff.ranges.size() == 2);
+    CHECK(diff.version == map.getVersion());
+    applyUpdate(client, diff);
+    CHECK(client == pixelsFrom("AAAA....AA...................XX."));
+    
+    // A client from the middle version only needs the last change
+    HeapMapUpdate partial = map.getUpdate(diff.version - 1);
+    CHECK(!partial.full && partial.ranges.size() == 1 && partial.ranges[0].start == 29);
+    
+    // Past half the map changed, a full update is sent instead
+    map.refresh(pixelsFrom("AAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAA"), now);
+    CHECK(map.getUpdate(diff.version).full);
+}
+
+void testHistoryOverflow() {
+    uint64_t versions = 0;
+    HeapMap map(4, versions);
+    auto now = std::chrono::steady_clock::now();
+    
+    map.refresh(pixelsFrom("...."), now);
+    uint64_t clientVersion = map.getVersion();
+    for (size_t i = 0; i <= HeapMap::HISTORY_SIZE; ++i) {
+        map.refresh(pixelsFrom(i % 2 ? "...." : "A..."), now);
+    }
+    
+    // The client's changes fell out of the history
+    CHECK(map.getUpdate(clientVersion).full);
+    CHECK(!map.getUpdate(map.getVersion() - 1).full);
+}
+
+void testVersionsAreNotShared() {
+    uint64_t versions = 0;
+    auto now = std::chrono::steady_clock::now();
+    
+    HeapMap wide(8, versions);
+    wide.refresh(pixelsFrom("AAAA...."), now);
+    wide.refresh(pixelsFrom("AAAAA..."), now);
+    uint64_t wideVersion = wide.getVersion();
+    
+    // A map recreated for the same width must not answer an old client with "unchanged"
+    // or a diff against pixels that client never had
+    HeapMap recreated(8, versions);
+    recreated.refresh(pixelsFrom("AAAA...."), now);
+    CHECK(recreated.getVersion() > wideVersion);
+    HeapMapUpdate update = recreated.getUpdate(wideVersion);
+    CHECK(update.full);
+    
+    // Nor a version it has not reached yet
+    HeapMapUpdate ahead = recreated.getUpdate(recreated.getVersion() + 5);
+    CHECK(ahead.full);
+    
+    recreated.refresh(pixelsFrom("AAAA..AA"), now);
+    CHECK(recreated.getUpdate(wideVersion).full);
+    CHECK(!recreated.getUpdate(recreated.getVersion() - 1).full);
+}
+
+void testManagerRendersByOffset() {
+    MemoryManager manager(2, 16ULL * 1024 * 1024);
+    std::vector<std::shared_ptr<MemoryBlock>> held;
+    for (int i = 0; i < 64; ++i) {
+        held.push_back(manager.allocateMemory(64 * 1024));
+    }
+    for (size_t i = 0; i < held.size(); i += 3) {
+        if (held[i]) {
+            manager.freeMemory(held[i]);
+        }
+    }
+    
+    // Reference picture built from block offsets
+    const uint32_t width = 256;
+    std::vector<std::array<size_t, 3>> bytes(width, std::array<size_t, 3>{{0, 0, 0}});
+    size_t total = manager.getTotalMemory();
+    for (const auto& block : manager.getAllBlocks()) {
+        for (size_t offset = block->getOffset(); offset < block->getOffset() + block->getSize(); offset += 512) {
+            bytes[offset * width / total][static_cast<size_t>(block->getStatus())] += 512;
+        }
+    }
+    
+    HeapMapUpdate update = manager.getHeapMap(width);
+    std::vector<BlockStatus> pixels;
+    applyUpdate(pixels, update);
+    size_t mismatches = 0;
+    for (uint32_t i = 0; i < width; ++i) {
+        size_t dominant = std::max_element(bytes[i].begin(), bytes[i].end()) - bytes[i].begin();
+        if (pixels[i] != static_cast<BlockStatus>(dominant)) {
+            ++mismatches;
+        }
+    }
+    CHECK(mismatches == 0);
+}
+
+void testManagerEviction() {
+    MemoryManager manager(1, 16ULL * 1024 * 1024);
+    
+    HeapMapUpdate first = manager.getHeapMap(100);
+    CHECK(first.full);
+    
+    // Enough other widths to push width 100 out of the cache
+    for (uint32_t width = 200; width < 200 + MemoryManager::MAX_HEAP_MAPS; ++width) {
+        manager.getHeapMap(width);
+    }
+    
+    // The recreated map knows nothing of the old version and resyncs the client in full
+    HeapMapUpdate again = manager.getHeapMap(100, first.version);
+    CHECK(again.full);
+    CHECK(again.version != first.version);
+}
+
+} // namespace
+
+int main() {
+    testDiffsAcrossVersions();
+    testHistoryOverflow();
+    testVersionsAreNotShared();
+    testManagerRendersByOffset();
+    testManagerEviction();
+    return testResult("heap_map_test");
+}
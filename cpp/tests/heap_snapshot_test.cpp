@@ -0,0 +1,157 @@
+#include "../heap_snapshot.h"
+#include "../memory_manager.h"
+#include "test_util.h"
+
+#include <filesystem>
+#include <fstream>
+#include <future>
+#include <unistd.h>
+#include <vector>
+
+namespace {
+
+const size_t HEAP_SIZE = 64ULL * 1024 * 1024;
+
+// Scratch directory, removed with everything in it when the test ends
+struct TempDirectory {
+    std::filesystem::path path;
+    
+    TempDirectory() {
+        path = std::filesystem::temp_directory_path() / ("heap_snapshot_test." + std::to_string(::getpid()));
+        std::filesystem::create_directories(path);
+    }
+    ~TempDirectory() {
+        std::filesystem::remove_all(path);
+    }
+    std::string file(const std::string& name) const {
+        return (path / name).string();
+    }
+};
+
+// A snapshot with the given block sizes, all in arena 0
+HeapSnapshot makeSnapshot(const std::vector<uint64_t>& blockSizes) {
+    HeapSnapshot snapshot;
+    snapshot.getStats().nextBlockId = static_cast<int32_t>(blockSizes.size() + 1);
+    for (size_t i = 0; i < blockSizes.size(); ++i) {
+        SnapshotBlock record = {};
+        record.size = blockSizes[i];
+        record.id = static_cast<int32_t>(i + 1);
+        record.status = static_cast<uint8_t>(BlockStatus::FREE);
+        snapshot.getBlocks().push_back(record);
+    }
+    snapshot.setArenaCount(1);
+    return snapshot;
+}
+
+void testRoundTrip(const TempDirectory& directory) {
+    std::string path = directory.file("round_trip.snap");
+    
+    MemoryManager source(2, HEAP_SIZE);
+    for (int i = 0; i < 16; ++i) {
+        source.allocateMemory(4096);
+    }
+    CHECK(source.saveSnapshot(path).get());
+    
+    MappedHeapSnapshot mapped;
+    CHECK(mapped.open(path));
+    uint64_t blockBytes = 0;
+    for (uint64_t i = 0; i < mapped.getHeader().blockCount; ++i) {
+        blockBytes += mapped.getBlocks()[i].size;
+    }
+    CHECK(mapped.getHeader().arenaCount == 2);
+    mapped.close();
+    
+    MemoryManager target(2, HEAP_SIZE);
+    CHECK(target.restoreSnapshot(path));
+    CHECK(target.getTotalMemory() == blockBytes);
+}
+
+void testTotalMemoryFromBlocks(const TempDirectory& directory) {
+    std::string path = directory.file("total.snap");
+    
+    // The stats record claims far more than the blocks hold; the blocks win
+    HeapSnapshot snapshot = makeSnapshot({4096, 8192, 16384});
+    snapshot.getStats().totalMemory = HEAP_SIZE;
+    CHECK(snapshot.write(path));
+    
+    MemoryManager manager(1, HEAP_SIZE);
+    CHECK(manager.restoreSnapshot(path));
+    CHECK(manager.getTotalMemory() == 4096 + 8192 + 16384);
+}
+
+void testOversized(const TempDirectory& directory) {
+    std::string path = directory.file("oversized.snap");
+    CHECK(makeSnapshot({HEAP_SIZE / 2, HEAP_SIZE / 2 + 1}).write(path));
+    
+    MemoryManager manager(1, HEAP_SIZE);
+    size_t totalBefore = manager.getTotalMemory();
+    CHECK(!manager.restoreSnapshot(path));
+    CHECK(manager.getTotalMemory() == totalBefore);
+}
+
+void testCorrupt(const TempDirectory& directory) {
+    std::string path = directory.file("corrupt.snap");
+    CHECK(makeSnapshot({4096, 4096}).write(path));
+    
+    // Flip one byte of the last block record; the checksum no longer matches
+    {
+        std::fstream file(path, std::ios::binary | std::ios::in | std::ios::out);
+        file.seekg(-8, std::ios::end);
+        char byte = 0;
+        file.read(&byte, 1);
+        byte ^= 0x40;
+        file.seekp(-8, std::ios::end);
+        file.write(&byte, 1);
+    }
+    MappedHeapSnapshot mapped;
+    CHECK(!mapped.open(path));
+    
+    MemoryManager manager(1, HEAP_SIZE);
+    CHECK(!manager.restoreSnapshot(path));
+    
+    // Truncated files fail the size checks before the checksum is read
+    CHECK(makeSnapshot({4096, 4096}).write(path));
+    std::filesystem::resize_file(path, std::filesystem::file_size(path) - sizeof(SnapshotBlock));
+    CHECK(!mapped.open(path));
+    
+    std::filesystem::resize_file(path, sizeof(SnapshotHeader) - 1);
+    CHECK(!mapped.open(path));
+    
+    CHECK(!mapped.open(directory.file("missing.snap")));
+}
+
+void testConcurrentSaves(const TempDirectory& directory) {
+    std::string path = directory.file("concurrent.snap");
+    
+    MemoryManager manager(2, HEAP_SIZE);
+    std::vector<std::future<bool>> saves;
+    for (int i = 0; i < 8; ++i) {
+        saves.push_back(manager.saveSnapshot(path));
+    }
+    for (auto& save : saves) {
+        CHECK(save.get());
+    }
+    
+    // Every save renamed its own whole file, so the survivor is valid and no temporaries remain
+    MappedHeapSnapshot mapped;
+    CHECK(mapped.open(path));
+    size_t files = 0;
+    for (const auto& entry : std::filesystem::directory_iterator(directory.path)) {
+        if (entry.path().filename().string().rfind("concurrent.snap", 0) == 0) {
+            ++files;
+        }
+    }
+    CHECK(files == 1);
+}
+
+} // namespace
+
+int main() {
+    TempDirectory directory;
+    testRoundTrip(directory);
+    testTotalMemoryFromBlocks(directory);
+    testOversized(directory);
+    testCorrupt(directory);
+    testConcurrentSaves(directory);
+    return testResult("heap_snapshot_test");
+}
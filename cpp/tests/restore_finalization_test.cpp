@@ -0,0 +1,95 @@
+#include "../memory_manager.h"
+#include "test_util.h"
+
+#include <condition_variable>
+#include <cstdlib>
+#include <filesystem>
+#include <future>
+#include <unistd.h>
+
+namespace {
+
+const size_t HEAP_SIZE = 16ULL * 1024 * 1024;
+
+// Finalizers hold here until the restore is waiting on them
+struct Gate {
+    std::mutex mutex;
+    std::condition_variable condition;
+    bool open = false;
+    
+    void wait() {
+        std::unique_lock<std::mutex> lock(mutex);
+        condition.wait(lock, [this]() { return open; });
+    }
+    void release() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            open = true;
+        }
+        condition.notify_all();
+    }
+};
+
+void testFinalizersAllocateDuringRestore() {
+    std::string path = (std::filesystem::temp_directory_path() /
+                        ("restore_finalization_test." + std::to_string(::getpid()) + ".snap")).string();
+    
+    MemoryManager manager(1, HEAP_SIZE);
+    CHECK(manager.saveSnapshot(path).get());
+    size_t snapshotTotal = manager.getTotalMemory();
+    
+    Gate gate;
+    std::atomic<int> started(0);
+    std::atomic<int> finished(0);
+    std::atomic<int> allocated(0);
+    
+    // Finalizers that allocate and collect, which both take locks a restore holds
+    for (int i = 0; i < 64; ++i) {
+        auto block = manager.allocateMemory(4096);
+        if (!block) {
+            continue;
+        }
+        manager.registerFinalizer(block, [&](const MemoryBlock&) {
+            started++;
+            gate.wait();
+            if (manager.allocateMemory(4096)) {
+                allocated++;
+            }
+            manager.runArenaCollection(0);
+            finished++;
+        });
+    }
+    
+    // Collect until at least one finalizer is queued and holding the worker
+    for (int attempt = 0; attempt < 100 && started == 0; ++attempt) {
+        manager.runGarbageCollection();
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    CHECK(started > 0);
+    
+    auto restore = std::async(std::launch::async, [&manager, &path]() { return manager.restoreSnapshot(path); });
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    gate.release();
+    
+    // A restore that waits for finalizers while holding memoryMutex never returns
+    if (restore.wait_for(std::chrono::seconds(30)) != std::future_status::ready) {
+        std::cerr << "restoreSnapshot deadlocked with an allocating finalizer" << std::endl;
+        std::_Exit(1);
+    }
+    CHECK(restore.get());
+    
+    // Every finalizer queued before the restore ran to completion before it returned
+    CHECK(finished == started);
+    CHECK(allocated > 0);
+    CHECK(manager.getPendingFinalizations() == 0);
+    CHECK(manager.getTotalMemory() == snapshotTotal);
+    
+    std::filesystem::remove(path);
+}
+
+} // namespace
+
+int main() {
+    testFinalizersAllocateDuringRestore();
+    return testResult("restore_finalization_test");
+}
@@ -0,0 +1,93 @@
+#include "../slab_allocator.h"
+#include "test_util.h"
+
+#include <vector>
+
+namespace {
+
+// Slabs come from plain active blocks; no MemoryManager is needed
+struct TestHeap {
+    int nextBlockId = 1;
+    std::vector<std::shared_ptr<MemoryBlock>> blocks;
+    
+    SlabAllocator makeAllocator() {
+        return SlabAllocator(
+            [this](size_t size) {
+                blocks.push_back(std::make_shared<MemoryBlock>(nextBlockId++, size, BlockStatus::ACTIVE));
+                return blocks.back();
+            },
+            [](const std::shared_ptr<MemoryBlock>& block) { block->setStatus(BlockStatus::FREE); });
+    }
+};
+
+void testFreeValidation() {
+    TestHeap heap;
+    SlabAllocator allocator = heap.makeAllocator();
+    
+    ObjectAllocation first;
+    ObjectAllocation second;
+    CHECK(allocator.allocate(24, first));
+    CHECK(allocator.allocate(24, second));
+    CHECK(first.blockId == second.blockId);
+    CHECK(allocator.getLiveBytes() == 48);
+    
+    // Misaligned offset inside a live slot
+    ObjectAllocation misaligned = second;
+    misaligned.offset += 1;
+    CHECK(!allocator.free(misaligned));
+    
+    // A size from another class must not find the slab
+    ObjectAllocation wrongClass = second;
+    wrongClass.size = 200;
+    CHECK(!allocator.free(wrongClass));
+    
+    // A block no slab uses
+    ObjectAllocation unknown = second;
+    unknown.blockId = 9999;
+    CHECK(!allocator.free(unknown));
+    
+    CHECK(allocator.getLiveBytes() == 48);
+    
+    CHECK(allocator.free(second));
+    CHECK(!allocator.free(second)); // Double free
+    CHECK(allocator.free(first));
+    CHECK(allocator.getLiveBytes() == 0);
+}
+
+void testSizeWithinClass() {
+    TestHeap heap;
+    SlabAllocator allocator = heap.makeAllocator();
+    
+    // 17..32 bytes share the 32-byte class, so a free may pass any size in it
+    ObjectAllocation allocation;
+    CHECK(allocator.allocate(20, allocation));
+    ObjectAllocation sameClass = allocation;
+    sameClass.size = 30;
+    CHECK(allocator.free(allocation));
+    CHECK(!allocator.free(sameClass)); // Already freed
+}
+
+void testDeadSlab() {
+    TestHeap heap;
+    SlabAllocator allocator = heap.makeAllocator();
+    
+    ObjectAllocation allocation;
+    CHECK(allocator.allocate(64, allocation));
+    CHECK(heap.blocks.size() == 1);
+    
+    // A collection freed the slab's block: the slab is forgotten and frees into it fail
+    heap.blocks[0]->setStatus(BlockStatus::FREE);
+    allocator.dropDeadSlabs();
+    CHECK(allocator.getSlabMemory() == 0);
+    CHECK(allocator.getLiveBytes() == 0);
+    CHECK(!allocator.free(allocation));
+}
+
+} // namespace
+
+int main() {
+    testFreeValidation();
+    testSizeWithinClass();
+    testDeadSlab();
+    return testResult("slab_allocator_test");
+}
@@ -0,0 +1,32 @@
+#ifndef TEST_UTIL_H
+#define TEST_UTIL_H
+
+#include <iostream>
+
+// Test helpers
+// CHECK records a failure and carries on, so one run reports every broken
+// expectation; main() returns testResult() so the exit status says whether
+// anything failed.
+inline int& testFailures() {
+    static int failures = 0;
+    return failures;
+}
+
+#define CHECK(condition)                                                                   \
+    do {                                                                                   \
+        if (!(condition)) {                                                                \
+            std::cerr << __FILE__ << ":" << __LINE__ << ": CHECK(" #condition ") failed" << std::endl; \
+            ++testFailures();                                                              \
+        }                                                                                  \
+    } while (0)
+
+inline int testResult(const char* name) {
+    if (testFailures() == 0) {
+        std::cout << name << ": passed" << std::endl;
+        return 0;
+    }
+    std::cout << name << ": " << testFailures() << " checks failed" << std::endl;
+    return 1;
+}
+
+#endif // TEST_UTIL_H
@@ -8,6 +8,9 @@ const navLinks = document.querySelectorAll('.sidebar-nav a');
 // Memory Manager instance
 let memoryManager;
 
+// Pixel width of the memory map widgets
+const HEAP_MAP_WIDTH = 200;
+
 // Initialize the application
 document.addEventListener('DOMContentLoaded', () => {
     // Initialize memory manager
@@ -134,9 +137,9 @@ function loadDashboardData() {
     const activities = memoryManager.getRecentActivities();
     updateGcActivitiesDisplay(activities);
     
-    // Get memory blocks
-    const blocks = memoryManager.getAllBlocks();
-    updateMemoryBlocksDisplay(blocks);
+    // Get memory map
+    const heapMap = memoryManager.requestHeapMap(HEAP_MAP_WIDTH);
+    updateHeapMapDisplay(heapMap);
     
     // Get GC algorithms
     const algorithms = memoryManager.getAllAlgorithms();
@@ -194,24 +197,6 @@ function updateGcActivitiesDisplay(activities) {
     });
 }
 
-// Update memory blocks display
-function updateMemoryBlocksDisplay(blocks) {
-    const container = document.getElementById('memory-blocks');
-    container.innerHTML = '';
-    
-    blocks.forEach(block => {
-        const blockElement = document.createElement('div');
-        blockElement.className = `memory-block ${block.status}`;
-        blockElement.style.width = `${block.size}px`;
-        blockElement.style.height = '20px';
-        blockElement.style.margin = '2px';
-        blockElement.style.display = 'inline-block';
-        blockElement.style.backgroundColor = getBlockColor(block.status);
-        blockElement.title = `Block ID: ${block.id}, Size: ${formatMemorySize(block.size)}, Status: ${block.status}`;
-        container.appendChild(blockElement);
-    });
-}
-
 // Update GC algorithms display
 function updateGcAlgorithmsDisplay(algorithms) {
     const container = document.getElementById('gc-algorithms-list');
@@ -370,9 +355,9 @@ function loadGcBrainData() {
     const algorithms = memoryManager.getAllAlgorithms();
     updateGcAlgorithmsDisplay(algorithms, 'gc-brain-algorithms-list');
     
-    // Get memory blocks visualization
-    const blocks = memoryManager.getAllBlocks();
-    updateMemoryBlocksDisplay(blocks, 'gc-brain-memory-blocks');
+    // Get memory map visualization
+    const heapMap = memoryManager.requestHeapMap(HEAP_MAP_WIDTH);
+    updateHeapMapDisplay(heapMap, 'gc-brain-memory-blocks');
     
     // Get GC activities
     const activities = memoryManager.getRecentActivities();
@@ -572,21 +557,30 @@ function updateGcAlgorithmsDisplay(algorithms, containerId = 'gc-algorithms-list
     });
 }
 
-// Update memory blocks display
-function updateMemoryBlocksDisplay(blocks, containerId = 'memory-blocks') {
+// Update memory map display
+function updateHeapMapDisplay(heapMap, containerId = 'memory-blocks') {
     const container = document.getElementById(containerId);
-    container.innerHTML = '';
     
-    blocks.forEach(block => {
-        const blockElement = document.createElement('div');
-        blockElement.className = `memory-block ${block.status}`;
-        blockElement.style.width = `${block.size}px`;
-        blockElement.style.height = '20px';
-        blockElement.style.margin = '2px';
-        blockElement.style.display = 'inline-block';
-        blockElement.style.backgroundColor = getBlockColor(block.status);
-        blockElement.title = `Block ID: ${block.id}, Size: ${formatMemorySize(block.size)}, Status: ${block.status}`;
-        container.appendChild(blockElement);
+    // Build one element per pixel once, then only touch the pixels whose status changed
+    if (container.children.length !== heapMap.width) {
+        container.innerHTML = '';
+        for (let i = 0; i < heapMap.width; i++) {
+            const pixelElement = document.createElement('div');
+            pixelElement.style.width = `${100 / heapMap.width}%`;
+            pixelElement.style.height = '20px';
+            pixelElement.style.display = 'inline-block';
+            container.appendChild(pixelElement);
+        }
+    }
+    
+    heapMap.pixels.forEach((status, i) => {
+        const pixelElement = container.children[i];
+        if (pixelElement.dataset.status !== status) {
+            pixelElement.dataset.status = status;
+            pixelElement.className = `memory-block ${status}`;
+            pixelElement.style.backgroundColor = getBlockColor(status);
+            pixelElement.title = `Heap ${(i * 100 / heapMap.width).toFixed(1)}%, Status: ${status}`;
+        }
     });
 }
 
@@ -23,6 +23,13 @@ class MemoryManager {
         
         this.activities = [];
         this.memoryBlocks = [];
+        
+        // Heap map kept in sync with the backend through run-length-encoded diffs
+        this.heapMap = {
+            version: 0,
+            width: 0,
+            pixels: []
+        };
         this.algorithms = [
             {
                 id: 1,
@@ -51,6 +58,13 @@ class MemoryManager {
                 description: 'Performs collection alongside program execution to minimize pauses.',
                 enabled: true,
                 performanceScore: 78
+            },
+            {
+                id: 5,
+                name: 'Region Evacuation',
+                description: 'Evacuates live data out of the most garbage-rich regions within a pause target, compacting the heap as it collects.',
+                enabled: false,
+                performanceScore: 84
             }
         ];
         
@@ -186,6 +200,114 @@ class MemoryManager {
         }
     }
     
+    // Request a heap map update for the given width
+    requestHeapMap(width) {
+        // Ask only for what changed since the version we hold; a new width starts from scratch
+        const message = {
+            command: 'getHeapMap',
+            width: width,
+            version: this.heapMap.width === width ? this.heapMap.version : 0
+        };
+        
+        // In a real implementation, this would send the message over the WebSocket connection
+        // and the backend's reply would be passed to applyHeapMapUpdate()
+        this.applyHeapMapUpdate(this.simulateHeapMapResponse(message));
+        return this.heapMap;
+    }
+    
+    // Apply a heap map update received from the backend
+    applyHeapMapUpdate(update) {
+        if (update.full || update.width !== this.heapMap.width) {
+            this.heapMap.pixels = new Array(update.width).fill('free');
+        }
+        
+        update.ranges.forEach(range => {
+            let pixel = range.start;
+            
+            // Runs are packed as status letter + length, e.g. "a12f3x1"
+            const runPattern = /([afx])(\d+)/g;
+            let match;
+            while ((match = runPattern.exec(range.runs)) !== null) {
+                const status = match[1] === 'a' ? 'active' : (match[1] === 'f' ? 'free' : 'fragmented');
+                const length = parseInt(match[2], 10);
+                
+                for (let i = 0; i < length; i++) {
+                    this.heapMap.pixels[pixel++] = status;
+                }
+            }
+        });
+        
+        this.heapMap.version = update.version;
+        this.heapMap.width = update.width;
+    }
+    
+    // Get the current heap map
+    getHeapMap() {
+        return this.heapMap;
+    }
+    
+    // Simulate the backend's heap map response for demo purposes
+    simulateHeapMapResponse(message) {
+        const blocks = this.getAllBlocks();
+        const totalSize = blocks.reduce((sum, block) => sum + block.size, 0) || 1;
+        
+        // Dominant status of the bytes behind each pixel
+        const pixelBytes = Array.from({ length: message.width }, () => ({ active: 0, free: 0, fragmented: 0 }));
+        let offset = 0;
+        blocks.forEach(block => {
+            for (let byte = 0; byte < block.size;) {
+                const pixel = Math.min(message.width - 1, Math.floor(offset * message.width / totalSize));
+                const pixelEnd = Math.ceil((pixel + 1) * totalSize / message.width);
+                const bytes = Math.max(1, Math.min(block.size - byte, pixelEnd - offset));
+                
+                pixelBytes[pixel][block.status] += bytes;
+                offset += bytes;
+                byte += bytes;
+            }
+        });
+        const pixels = pixelBytes.map(bytes => Object.keys(bytes).reduce((a, b) => bytes[a] >= bytes[b] ? a : b));
+        
+        // Encode every pixel that differs from what the client holds
+        const statusLetters = { active: 'a', free: 'f', fragmented: 'x' };
+        const encode = (start, end) => {
+            let runs = '';
+            for (let i = start; i < end;) {
+                let length = 1;
+                while (i + length < end && pixels[i + length] === pixels[i]) {
+                    length++;
+                }
+                runs += statusLetters[pixels[i]] + length;
+                i += length;
+            }
+            return { start: start, runs: runs };
+        };
+        
+        const full = message.version === 0;
+        const ranges = [];
+        if (full) {
+            ranges.push(encode(0, message.width));
+        } else {
+            for (let i = 0; i < message.width; i++) {
+                if (pixels[i] !== this.heapMap.pixels[i]) {
+                    let end = i + 1;
+                    while (end < message.width && pixels[end] !== this.heapMap.pixels[end]) {
+                        end++;
+                    }
+                    ranges.push(encode(i, end));
+                    i = end;
+                }
+            }
+        }
+        
+        return {
+            type: 'heapMap',
+            version: ranges.length > 0 || full ? this.heapMap.version + 1 : this.heapMap.version,
+            width: message.width,
+            full: full,
+            ranges: ranges
+        };
+    }
+    
     // Get all algorithms
     getAllAlgorithms() {
         return this.algorithms;